@@ -22,13 +22,17 @@
 #include "alignment.h"
 #include <string>
 #include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 // ============================================================================
 // ALIGNMENT CLASS
 // ============================================================================
 
-int AlignmentJan::align(const string& s1, const string& s2)
+int AlignmentJan::alignScalar(const string& s1, const string& s2, int minScore)
 {
         // reallocate memory if necessary
         int thisMaxDim = max(s1.length(), s2.length());
@@ -61,11 +65,148 @@ int AlignmentJan::align(const string& s1, const string& s2)
 
                         (*this)(i, j) = score;
                 }
+
+                if (minScore == INT_MIN)
+                        continue;
+
+                // upper bound to the final score from this row
+                int bound = INT_MIN;
+                int gain = max(max(match, mismatch), 0);
+                for (int j = max(0, i - maxIndel); j <= min((int)s2.length(), i + maxIndel); j++) {
+                        int remaining = min((int)s1.length() - i, (int)s2.length() - j);
+                        bound = max(bound, (*this)(i, j) + gain * remaining);
+                }
+                if (bound < minScore)
+                        return bound;
         }
 
         return (*this)(s1.length(), s2.length());
 }
 
+#ifdef __SSE2__
+
+bool AlignmentJan::canAlignSIMD(const string& s1, const string& s2) const
+{
+        // the band (2*maxIndel+1 cells) must fit in eight 16-bit lanes
+        if (maxIndel > 3)
+                return false;
+
+        // the final cell must lie within the band
+        int len1 = s1.length(), len2 = s2.length();
+        if (abs(len1 - len2) > maxIndel)
+                return false;
+
+        // all scores must stay well above the value of the cells outside
+        int maxAbs = max(abs(match), max(abs(mismatch), abs(gap)));
+        return (len1 + len2 + 8) * maxAbs < 8192;
+}
+
+// blend two vectors: lanes from a where the mask is set, else from b
+static inline __m128i blend(__m128i mask, __m128i a, __m128i b)
+{
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+int AlignmentJan::alignSIMD(const string& s1, const string& s2, int minScore)
+{
+        const int len1 = s1.length(), len2 = s2.length();
+        const int16_t NEG = -16384;     // value of the cells outside the band
+        const bool bounded = (minScore > NEG);
+
+        // s2 as 16-bit characters, padded such that every load is in bounds
+        seqBuf.assign(len2 + 24, 0);
+        for (int j = 0; j < len2; j++)
+                seqBuf[8 + j] = s2[j];
+
+        // lane l of a row i holds cell (i, j) with j = i - maxIndel + l
+        const __m128i lane = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m128i inBand = _mm_cmplt_epi16(lane, _mm_set1_epi16(2*maxIndel+1));
+        const __m128i vNeg = _mm_set1_epi16(NEG);
+        const __m128i vN = _mm_set1_epi16('N');
+        const __m128i vMatch = _mm_set1_epi16(match);
+        const __m128i vMismatch = _mm_set1_epi16(mismatch);
+        const __m128i vGap1 = _mm_set1_epi16(gap);
+        const __m128i vGap2 = _mm_set1_epi16(2*gap);
+        const __m128i vGap4 = _mm_set1_epi16(4*gap);
+        const __m128i vGain = _mm_set1_epi16(max(max(match, mismatch), 0));
+
+        // the lanes shifted in from the left are outside the band
+        const __m128i neg1 = _mm_setr_epi16(NEG, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i neg2 = _mm_setr_epi16(NEG, NEG, 0, 0, 0, 0, 0, 0);
+        const __m128i neg4 = _mm_setr_epi16(NEG, NEG, NEG, NEG, 0, 0, 0, 0);
+
+        // row 0: (0, j) = j * gap for 0 <= j <= maxIndel
+        __m128i jv = _mm_sub_epi16(lane, _mm_set1_epi16(maxIndel));
+        __m128i valid = _mm_and_si128(inBand, _mm_cmpgt_epi16(jv, _mm_set1_epi16(-1)));
+        __m128i prev = blend(valid, _mm_mullo_epi16(jv, vGap1), vNeg);
+
+        for (int i = 1; i <= len1; i++) {
+                jv = _mm_add_epi16(lane, _mm_set1_epi16(i - maxIndel));
+
+                // diagonal: (i-1, j-1) is in the same lane of the previous row
+                __m128i a = _mm_set1_epi16(s1[i-1]);
+                __m128i b = _mm_loadu_si128((const __m128i*)(seqBuf.data() + 8 + i - maxIndel - 1));
+                __m128i hit = _mm_or_si128(_mm_cmpeq_epi16(a, b), _mm_cmpeq_epi16(b, vN));
+                if (s1[i-1] == 'N')
+                        hit = _mm_cmpeq_epi16(a, a);
+                __m128i curr = _mm_adds_epi16(prev, blend(hit, vMatch, vMismatch));
+
+                // deletion: (i-1, j) is in the next lane of the previous row
+                __m128i del = _mm_adds_epi16(_mm_srli_si128(prev, 2), vGap1);
+                curr = _mm_max_epi16(curr, del);
+
+                // only cells 1 <= j <= len2 are computed, (i, 0) is a border
+                valid = _mm_and_si128(_mm_cmpgt_epi16(jv, _mm_setzero_si128()),
+                                      _mm_cmplt_epi16(jv, _mm_set1_epi16(len2 + 1)));
+                curr = blend(_mm_and_si128(valid, inBand), curr, vNeg);
+                if (i <= maxIndel)
+                        curr = blend(_mm_cmpeq_epi16(jv, _mm_setzero_si128()),
+                                     _mm_set1_epi16(i * gap), curr);
+
+                // insertion: (i, j-1) is in the previous lane of the same
+                // row, take the prefix maximum in log2(8) steps
+                curr = _mm_max_epi16(curr, _mm_adds_epi16(_mm_or_si128(_mm_slli_si128(curr, 2), neg1), vGap1));
+                curr = _mm_max_epi16(curr, _mm_adds_epi16(_mm_or_si128(_mm_slli_si128(curr, 4), neg2), vGap2));
+                curr = _mm_max_epi16(curr, _mm_adds_epi16(_mm_or_si128(_mm_slli_si128(curr, 8), neg4), vGap4));
+                prev = blend(inBand, curr, vNeg);
+
+                if (!bounded)
+                        continue;
+
+                // upper bound to the final score from this row: the maximum
+                // over the cells 0 <= j <= len2 of the band
+                __m128i remaining = _mm_min_epi16(_mm_set1_epi16(len1 - i),
+                                                  _mm_sub_epi16(_mm_set1_epi16(len2), jv));
+                valid = _mm_and_si128(_mm_cmpgt_epi16(jv, _mm_set1_epi16(-1)),
+                                      _mm_cmplt_epi16(jv, _mm_set1_epi16(len2 + 1)));
+                __m128i bound = blend(valid, _mm_adds_epi16(prev, _mm_mullo_epi16(vGain, remaining)), vNeg);
+                bound = _mm_max_epi16(bound, _mm_shuffle_epi32(bound, _MM_SHUFFLE(1, 0, 3, 2)));
+                bound = _mm_max_epi16(bound, _mm_shuffle_epi32(bound, _MM_SHUFFLE(2, 3, 0, 1)));
+                bound = _mm_max_epi16(bound, _mm_shufflelo_epi16(bound, _MM_SHUFFLE(2, 3, 0, 1)));
+                int maxScore = (int16_t)_mm_extract_epi16(bound, 0);
+                if (maxScore < minScore)
+                        return maxScore;
+        }
+
+        int16_t row[8];
+        _mm_storeu_si128((__m128i*)row, prev);
+        return row[maxIndel - len1 + len2];
+}
+
+#else
+
+bool AlignmentJan::canAlignSIMD(const string& s1, const string& s2) const
+{
+        return false;
+}
+
+int AlignmentJan::alignSIMD(const string& s1, const string& s2, int minScore)
+{
+        return alignScalar(s1, s2, minScore);
+}
+
+#endif
+
 AlignmentJan::AlignmentJan(int maxDim_, int maxIndel_, int match_,
                            int mismatch_, int gap_) : maxDim(maxDim_),
                            maxIndel(maxIndel_), match(match_),
@@ -26,6 +26,9 @@
 #include "global.h"
 #include "tstring.h"
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#include <climits>
 
 using namespace std;
 
@@ -42,6 +45,26 @@ private:
         int mismatch;           // mismatch penalty
         int gap;                // gap score
         int *M;                 // alignment matrix
+        std::vector<int16_t> seqBuf;    // padded copy of s2 (SIMD aligner)
+
+        /**
+         * Check whether the vectorized aligner can handle two sequences: the
+         * band must fit in a single register and the scores in 16 bits
+         * @param s1 First string
+         * @param s2 Second string
+         * @return True if alignSIMD returns the same score as alignScalar
+         */
+        bool canAlignSIMD(const string &s1, const string &s2) const;
+
+        /**
+         * Perform the alignment with SSE2 instructions, one band row at a
+         * time. The alignment matrix is not stored.
+         * @param s1 First string
+         * @param s2 Second string
+         * @param minScore Stop as soon as this score can no longer be reached
+         * @return The alignment score, or a value below minScore
+         */
+        int alignSIMD(const string &s1, const string &s2, int minScore);
 
         // void traceback(string& s1,string& s2,char **traceback );
         // void init();
@@ -58,6 +81,28 @@ public:
         AlignmentJan(int maxDim, int maxIndel = 3, int match = 1,
                      int mismatch = -1, int gap = -3);
 
+        /**
+         * Get the score of the gapless alignment of two equally long
+         * sequences
+         * @param length Length of the sequences
+         * @param numMismatches Number of mismatches
+         * @return The gapless alignment score
+         */
+        int getGaplessScore(int length, int numMismatches) const {
+                return (length - numMismatches) * match + numMismatches * mismatch;
+        }
+
+        /**
+         * Check whether the gapless alignment of two equally long sequences
+         * is optimal. A gapped alignment needs at least one insertion and
+         * one deletion and hence scores at most (length-1)*match + 2*gap.
+         * @param numMismatches Number of mismatches in the gapless alignment
+         * @return True if no gapped alignment can score higher
+         */
+        bool isGaplessOptimal(int numMismatches) const {
+                return numMismatches * (match - mismatch) <= match - 2 * gap;
+        }
+
         /**
          * Destructor
          */
@@ -78,20 +123,52 @@ public:
         }
 
         /**
-         * Perform the alignment between two sequences
+         * Perform the alignment between two sequences, using the vectorized
+         * aligner when possible
          * @param s1 First string
          * @param s2 Second string
          * @return The alignment score (higher is better)
          */
-        int align(const string &s1, const string &s2);
+        int align(const string &s1, const string &s2) {
+                return alignBounded(s1, s2, INT_MIN);
+        }
+
+        /**
+         * Perform the alignment between two sequences, but stop as soon as
+         * a minimum score can no longer be reached. After every row of the
+         * band, the best score of a cell plus the maximal gain over the
+         * remaining characters bounds the final score (score-bound pruning,
+         * not X-drop: paths are never compared with the best score so far).
+         * @param s1 First string
+         * @param s2 Second string
+         * @param minScore Minimum score of interest
+         * @return The alignment score if it is at least minScore, otherwise
+         * a value below minScore
+         */
+        int alignBounded(const string &s1, const string &s2, int minScore) {
+                if (canAlignSIMD(s1, s2))
+                        return alignSIMD(s1, s2, minScore);
+                return alignScalar(s1, s2, minScore);
+        }
+
+        /**
+         * Perform the alignment between two sequences, one cell at a time,
+         * and store the alignment matrix
+         * @param s1 First string
+         * @param s2 Second string
+         * @param minScore Stop as soon as this score can no longer be reached
+         * @return The alignment score, or a value below minScore
+         */
+        int alignScalar(const string &s1, const string &s2,
+                        int minScore = INT_MIN);
 
         /**
-         * Print matrix to stdout
+         * Print matrix to stdout (after alignScalar)
          */
         void printMatrix() const;
 
         /**
-         * Print matrix to stdout
+         * Print matrix to stdout (after alignScalar)
          */
         void printAlignment(const string &s1, const string &s2) const;
 };
@@ -59,15 +59,11 @@ void Brownie::parameterEstimationInStage4(DBGraph &graph){
         readLength = libraries.getAvgReadLength();
         if (readLength <= settings.getK() || readLength > 500)
                 readLength = 150;
-        cout << "Loading test graph for initial parameter estimation" << endl;
+        // simplify a copy of the topology and coverage, not the sequences
+        cout << "Cloning graph for initial parameter estimation" << endl;
         DBGraph testgraph(settings);
-        testgraph.loadGraphBin(getBinNodeFilename(3),
-                               getBinArcFilename(3),
-                               getMetaDataFilename(3));
+        testgraph.cloneTopology(graph);
         testgraph.readLength = readLength;
-        #ifdef DEBUG
-        testgraph.compareToSolution(getTrueMultFilename(3), true);
-        #endif
         testgraph.clipTips(0);
         testgraph.mergeSingleNodes(true);
         testgraph.filterCoverage(testgraph.cutOffvalue);
@@ -86,8 +82,8 @@ void Brownie::parameterEstimationInStage4(DBGraph &graph){
                 cutOffvalue = settings.getCutOffValue();
         else
                 cutOffvalue = (estimatedErroneousKmerCoverage-estimatedKmerCoverage)* (log(e)/log(c));
-        testgraph.updateGraphSize();
         testgraph.clear();
+        graph.setStaticPointers();
            //initialize values for graph parameter based on test graph.
         graph.estimatedKmerCoverage = estimatedKmerCoverage;
         graph.estimatedMKmerCoverageSTD = estimatedMKmerCoverageSTD;
@@ -225,6 +221,9 @@ void Brownie::stageThree()
         cout << "done (" << graph.getNumNodes() << " nodes, "
              << graph.getNumArcs() << " arcs)" << endl;
 
+        // node identifiers from stage 2 follow the kmer table order
+        graph.reorderNodes();
+
         Util::startChrono();
         graph.countNodeandArcFrequency(libraries);
         cout << "Done counting multiplicity (" << Util::stopChronoStr() << ")" << endl;
@@ -254,7 +253,6 @@ void Brownie::stageFour()
                  return;
         }
         DBGraph graph(settings);
-        parameterEstimationInStage4( graph );
 
         Util::startChrono();
         cout << "Creating graph... ";
@@ -272,6 +270,7 @@ void Brownie::stageFour()
 #ifdef DEBUG
         graph.compareToSolution(getTrueMultFilename(3), true);
 #endif
+        parameterEstimationInStage4( graph );
         Util::startChrono();
         graph.graphPurification(getTrueMultFilename(3), libraries);
 #ifdef DEBUG
@@ -320,7 +319,7 @@ void Brownie::stageFive()
 #endif
 
         Util::startChrono();
-        ReadCorrectionHandler rcHandler(graph, settings);
+        ReadCorrectionHandler rcHandler(graph, settings, getEssaMEMFilename());
         rcHandler.doErrorCorrection(libraries);
 
         cout << "Error correction completed in " << Util::stopChronoStr() << endl;
@@ -125,6 +125,14 @@ public:
                 return settings.addTempDirectory("truemult.stage") + stageStr;
         }
 
+        /**
+         * Get the filename of the essaMEM index of the stage 4 graph
+         * @return String containing the essaMEM index filename
+         */
+        std::string getEssaMEMFilename() const {
+                return settings.addTempDirectory("essamem.stage4");
+        }
+
         /**
          * Get the kmer filename
          * @return The kmer filename
@@ -42,6 +42,20 @@ struct comparator {
         }
 };
 
+class BubbleCandidate {
+public:
+        NodeID rootID;          // branching node where both paths start
+        NodeID upID;            // first node of the upper path
+        NodeID upLastID;        // last node of the upper path
+        NodeID downID;          // first node of the lower path
+        NodeID downLastID;      // last node of the lower path
+
+        BubbleCandidate(NodeID rootID, const vector<NodeID>& upPath,
+                        const vector<NodeID>& downPath) : rootID(rootID),
+                upID(upPath[1]), upLastID(upPath.back()),
+                downID(downPath[1]), downLastID(downPath.back()) {};
+};
+
 bool DBGraph::removeBubble(SSNode &prevFirstNode ,SSNode& extendFirstNode,size_t &TP,size_t &TN,size_t &FP,size_t &FN,size_t & numOfDel ){
         bool preIsSingle=true;
         bool exteIsSingle=true;
@@ -256,29 +270,19 @@ bool DBGraph::whichOneIsbubble(SSNode rootNode,bool &first, SSNode &prevFirstNod
         return false;
 }
 
-void DBGraph::extractPath(NodeID currID, const vector<NodeID>& prevNode) const
+void DBGraph::extractPath(NodeID currID, const ScratchMap<NodeID, NodeID>& prevNode) const
 {
-        vector<NodeID> path;
-        path.push_back(currID);
-
-        while (true) {
-                currID = prevNode[currID + numNodes];
-                if (currID == 0)
-                        break;
-                path.push_back(currID);
-        }
-
-        reverse(path.begin(), path.end());
+        vector<NodeID> path = getPath(currID, prevNode);
         for (auto it : path)
                 cout << it << " ";
 }
-vector<NodeID> DBGraph::getPath(NodeID currID, const vector<NodeID>& prevNode) const
+vector<NodeID> DBGraph::getPath(NodeID currID, const ScratchMap<NodeID, NodeID>& prevNode) const
 {
         vector<NodeID> path;
         path.push_back(currID);
 
         while (true) {
-                currID = prevNode[currID + numNodes];
+                currID = prevNode.get(currID);
                 if (currID == 0)
                         break;
                 path.push_back(currID);
@@ -288,7 +292,7 @@ vector<NodeID> DBGraph::getPath(NodeID currID, const vector<NodeID>& prevNode) c
         return path;
 }
 
-vector<pair<vector<NodeID>, vector<NodeID> > >  DBGraph::searchForParallelNodes(SSNode node,vector<NodeID> &visited, vector<NodeID> &prevNode,vector<NodeID> &nodeColor, int depth){
+vector<pair<vector<NodeID>, vector<NodeID> > >  DBGraph::searchForParallelNodes(SSNode node, ScratchMap<NodeID, NodeID> &prevNode, ScratchMap<NodeID, NodeID> &nodeColor, int depth){
         size_t maxLength = depth;
         NodeID lID=node.getNodeID();
         priority_queue<PathInfo, vector<PathInfo>, comparator> heap;
@@ -308,12 +312,12 @@ vector<pair<vector<NodeID>, vector<NodeID> > >  DBGraph::searchForParallelNodes(
                         SSNode next = getSSNode(nextID);
 
                         // do we encounter a node previously encountered?
-                        if ((prevNode[nextID + numNodes] != 0) || (nextID == lID)) {
-                                if (nodeColor[nextID + numNodes] == nodeColor[currID + numNodes])
+                        if (prevNode.contains(nextID) || (nextID == lID)) {
+                                if (nodeColor.get(nextID) == nodeColor.get(currID))
                                         continue;
 
-                                NodeID upNodeID=nodeColor[currID + numNodes];
-                                NodeID downNodeID=nodeColor[nextID + numNodes];
+                                NodeID upNodeID=nodeColor.get(currID);
+                                NodeID downNodeID=nodeColor.get(nextID);
                                 if (upNodeID!=0&&downNodeID!=0){
                                         vector<NodeID> upPathElements=getPath(currID, prevNode);
                                         vector<NodeID> downPathElements=getPath(nextID, prevNode);
@@ -321,14 +325,13 @@ vector<pair<vector<NodeID>, vector<NodeID> > >  DBGraph::searchForParallelNodes(
                                 }
 
                         } else {
-                                prevNode[nextID + numNodes] = currID;
-                                nodeColor[nextID + numNodes] = (currID == lID) ? nextID : nodeColor[currID + numNodes];
-                                visited.push_back(nextID);
+                                prevNode[nextID] = currID;
+                                nodeColor[nextID] = (currID == lID) ? nextID : nodeColor.get(currID);
 
                                 size_t nextLength = currLength + next.getMarginalLength();
                                 if (nextLength > maxLength)
                                         continue;
-                                if (visited.size()>visitedNodesLimit)
+                                if (prevNode.size()>visitedNodesLimit)
                                         continue;
                                 PathInfo nextTop(nextID, nextLength);
                                 heap.push(nextTop);
@@ -336,62 +339,149 @@ vector<pair<vector<NodeID>, vector<NodeID> > >  DBGraph::searchForParallelNodes(
                 }
         }
 
-       for (auto it : visited) {
-                prevNode[it + numNodes] = 0;
-                nodeColor[it + numNodes] = 0;
-        }
-        visited.clear();
+        prevNode.clear();
+        nodeColor.clear();
 
         return parallelNodes;
 }
+void DBGraph::getBubbleRoots(NodeID nodeID, size_t depth,
+                             ScratchMap<NodeID, size_t>& dist,
+                             vector<NodeID>& roots) const
+{
+        // a search from a root visits the nodes at distance <= depth and
+        // inspects their right neighbours: walk left from the node while the
+        // nodes in between are within that distance
+        roots.push_back(nodeID);
+        vector<pair<NodeID, size_t> > todo(1, make_pair(nodeID, 0));
+        while (!todo.empty()) {
+                NodeID currID = todo.back().first;
+                size_t currDist = todo.back().second;
+                todo.pop_back();
+
+                SSNode curr = getSSNode(currID);
+                if (!curr.isValid())
+                        continue;
+                for (ArcIt it = curr.leftBegin(); it != curr.leftEnd(); it++) {
+                        NodeID prevID = it->getNodeID();
+                        roots.push_back(prevID);
+
+                        size_t prevDist = currDist + getSSNode(prevID).getMarginalLength();
+                        if (prevDist > depth)
+                                continue;
+                        if (dist.contains(prevID) && dist.get(prevID) <= prevDist)
+                                continue;
+                        dist[prevID] = prevDist;
+                        todo.push_back(make_pair(prevID, prevDist));
+                }
+        }
+
+        dist.clear();
+}
+
 vector<pair<vector<NodeID>, vector<NodeID>> >  DBGraph::searchForParallelNodes(SSNode node, int depth){
-        vector<NodeID> prevNode(2*numNodes+1, 0);
-        vector<NodeID> nodeColor(2*numNodes+1, 0);
-        vector<NodeID> visited;
-        return (searchForParallelNodes(node, visited,nodeColor,prevNode, depth));
+        ScratchMap<NodeID, NodeID> prevNode, nodeColor;
+        return (searchForParallelNodes(node, prevNode, nodeColor, depth));
 }
 bool DBGraph::bubbleDetection(int depth) {
 
         size_t numOfDel=0;
         size_t TP=0,TN=0,FP=0,FN=0;
-        vector<NodeID> prevNode(2*numNodes+1, 0);
-        vector<NodeID> nodeColor(2*numNodes+1, 0);
-        vector<pair<NodeID, NodeID> > parallelNodes;
-        vector<NodeID> visited;
-        for (NodeID lID = -numNodes; lID <numNodes; lID++) {
-                if (lID % OUTPUT_FREQUENCY == 0)
-                        (cout << "Extracting node -" <<numNodes<< "/ "<<lID<<" /"<<numNodes
-                        << " from graph          \r").flush();
-                if ( lID == 0 )
-                        continue;
+
+        // search for parallel paths from all branching nodes in parallel,
+        // every thread reuses its own scratch maps for the searches
+        const size_t numThreads = settings.getNumThreads();
+        vector<ScratchMap<NodeID, NodeID> > prevNode(numThreads), nodeColor(numThreads);
+        vector<vector<BubbleCandidate> > threadCandidates(numThreads);
+
+        auto searchFromRoot = [&](size_t threadID, NodeID lID) {
                 SSNode node = getSSNode(lID);
                 if (!node.isValid())
-                        continue;
+                        return;
                 // only consider nodes that branch
                 if (node.getNumRightArcs() < 2)
-                        continue;
+                        return;
                 if (!hasLowCovNode(node))
+                        return;
+                vector<pair<vector<NodeID>, vector<NodeID>> > parallelPath=searchForParallelNodes(node, prevNode[threadID], nodeColor[threadID], depth);
+                for (auto it : parallelPath)
+                        threadCandidates[threadID].push_back(BubbleCandidate(lID, it.first, it.second));
+        };
+
+        // only searches that reach a node that changed since the previous
+        // run with the same depth can find new bubbles
+        vector<NodeID> worklist;
+        bool incremental = getWorklist(bubbleState[depth], {cutOffvalue,
+                (double)maxNodeSizeToDel}, worklist);
+
+        if (!incremental) {
+                parallelFor(1, numNodes + 1, [&](size_t threadID, size_t id) {
+                        searchFromRoot(threadID, -(NodeID)id);
+                        searchFromRoot(threadID, id);
+                });
+        } else {
+                vector<ScratchMap<NodeID, size_t> > dist(numThreads);
+                vector<vector<NodeID> > threadRoots(numThreads);
+                parallelFor(0, worklist.size(), [&](size_t threadID, size_t i) {
+                        getBubbleRoots(worklist[i], depth, dist[threadID], threadRoots[threadID]);
+                        getBubbleRoots(-worklist[i], depth, dist[threadID], threadRoots[threadID]);
+                });
+
+                vector<NodeID> roots;
+                for (size_t i = 0; i < numThreads; i++)
+                        roots.insert(roots.end(), threadRoots[i].begin(), threadRoots[i].end());
+                sort(roots.begin(), roots.end());
+                roots.erase(unique(roots.begin(), roots.end()), roots.end());
+
+                parallelFor(0, roots.size(), [&](size_t threadID, size_t i) {
+                        searchFromRoot(threadID, roots[i]);
+                });
+        }
+
+        vector<BubbleCandidate> candidates;
+        for (size_t i = 0; i < numThreads; i++)
+                candidates.insert(candidates.end(), threadCandidates[i].begin(), threadCandidates[i].end());
+        threadCandidates.clear();
+
+        // resolve the bubbles one root after the other, as if the roots were
+        // processed serially: bubbles can overlap, so first check that an
+        // earlier removal did not already resolve this one
+        stable_sort(candidates.begin(), candidates.end(),
+                    [](const BubbleCandidate& a, const BubbleCandidate& b) {
+                return a.rootID < b.rootID; });
+
+        for (const BubbleCandidate& c : candidates) {
+                SSNode node = getSSNode(c.rootID);
+                if (!node.isValid() || node.getNumRightArcs() < 2)
                         continue;
-                vector<pair<vector<NodeID>, vector<NodeID>> > parallelPath=searchForParallelNodes(node, visited,nodeColor,prevNode, depth);
-                for (auto it : parallelPath){
-
-                        vector<NodeID> upPath=it.first;
-                        vector<NodeID> downPath=it.second;
-
-                        SSNode upLast=getSSNode(it.first[upPath.size()-1]);
-                        SSNode downLast=getSSNode(it.second[downPath.size()-1]);
-                        SSNode up=getSSNode(it.first[1]);
-                        SSNode down=getSSNode(it.second[1]);
-                        if(up.isValid()&&down.isValid())
-                        {
-                                bool upIsBubble=true;
-                                bool bubbleDeleted=false;
-                                if (whichOneIsbubble(node,upIsBubble,up, down,false,this->cutOffvalue)){
-                                        if (upIsBubble){
+
+                SSNode upLast=getSSNode(c.upLastID);
+                SSNode downLast=getSSNode(c.downLastID);
+                SSNode up=getSSNode(c.upID);
+                SSNode down=getSSNode(c.downID);
+                if(up.isValid()&&down.isValid())
+                {
+                        bool upIsBubble=true;
+                        bool bubbleDeleted=false;
+                        if (whichOneIsbubble(node,upIsBubble,up, down,false,this->cutOffvalue)){
+                                if (upIsBubble){
+                                        #ifdef DEBUG
+                                        size_t mul=trueMult[abs( up.getNodeID())];
+                                        #endif
+                                        if (removeNode(up)){
+                                                #ifdef DEBUG
+                                                if (mul>0)
+                                                        FP++;
+                                                else
+                                                        TP++;
+                                                #endif
+                                                bubbleDeleted=true;
+                                                numOfDel++;
+                                        }
+                                        if (upLast.isValid()&&upLast.getNodeKmerCov()<cutOffvalue){//&& node.getNodeKmerCov()/upLast.getNodeKmerCov()>3){
                                                 #ifdef DEBUG
-                                                size_t mul=trueMult[abs( up.getNodeID())];
+                                                mul=trueMult[abs( upLast.getNodeID())];
                                                 #endif
-                                                if (removeNode(up)){
+                                                if (removeNode(upLast)){
                                                         #ifdef DEBUG
                                                         if (mul>0)
                                                                 FP++;
@@ -401,27 +491,27 @@ bool DBGraph::bubbleDetection(int depth) {
                                                         bubbleDeleted=true;
                                                         numOfDel++;
                                                 }
-                                                if (upLast.isValid()&&upLast.getNodeKmerCov()<cutOffvalue){//&& node.getNodeKmerCov()/upLast.getNodeKmerCov()>3){
-                                                        #ifdef DEBUG
-                                                        mul=trueMult[abs( upLast.getNodeID())];
-                                                        #endif
-                                                        if (removeNode(upLast)){
-                                                                #ifdef DEBUG
-                                                                if (mul>0)
-                                                                        FP++;
-                                                                else
-                                                                        TP++;
-                                                                #endif
-                                                                bubbleDeleted=true;
-                                                                numOfDel++;
-                                                        }
-                                                }
                                         }
-                                        else{
+                                }
+                                else{
+                                        #ifdef DEBUG
+                                        size_t mul=trueMult[abs( down.getNodeID())];
+                                        #endif
+                                        if( removeNode(down)){
+                                                #ifdef DEBUG
+                                                if (mul>0)
+                                                        FP++;
+                                                else
+                                                        TP++;
+                                                #endif
+                                                bubbleDeleted=true;
+                                                numOfDel++;
+                                        }
+                                        if (downLast.isValid()&&downLast.getNodeKmerCov()<cutOffvalue){// && node.getNodeKmerCov()/downLast.getNodeKmerCov()>3){
                                                 #ifdef DEBUG
-                                                size_t mul=trueMult[abs( down.getNodeID())];
+                                                mul=trueMult[abs( downLast.getNodeID())];
                                                 #endif
-                                                if( removeNode(down)){
+                                                if( removeNode(downLast)){
                                                         #ifdef DEBUG
                                                         if (mul>0)
                                                                 FP++;
@@ -431,42 +521,26 @@ bool DBGraph::bubbleDetection(int depth) {
                                                         bubbleDeleted=true;
                                                         numOfDel++;
                                                 }
-                                                if (downLast.isValid()&&downLast.getNodeKmerCov()<cutOffvalue){// && node.getNodeKmerCov()/downLast.getNodeKmerCov()>3){
-                                                        #ifdef DEBUG
-                                                        mul=trueMult[abs( downLast.getNodeID())];
-                                                        #endif
-                                                        if( removeNode(downLast)){
-                                                                #ifdef DEBUG
-                                                                if (mul>0)
-                                                                        FP++;
-                                                                else
-                                                                        TP++;
-                                                                #endif
-                                                                bubbleDeleted=true;
-                                                                numOfDel++;
-                                                        }
-                                                }
+                                        }
 
 
-                                        }
-                                }
-                                if(!bubbleDeleted){
-                                        #ifdef DEBUG
-                                        if (trueMult[abs( up.getNodeID())]>0)
-                                                TN++;
-                                        else
-                                                FN++;
-                                        if (trueMult[abs( down.getNodeID())]>0)
-                                                TN++;
-                                        else
-                                                FN++;
-                                        #endif
                                 }
-
                         }
+                        if(!bubbleDeleted){
+                                #ifdef DEBUG
+                                if (trueMult[abs( up.getNodeID())]>0)
+                                        TN++;
+                                else
+                                        FN++;
+                                if (trueMult[abs( down.getNodeID())]>0)
+                                        TN++;
+                                else
+                                        FN++;
+                                #endif
+                        }
+
                 }
         }
-        cout<<endl;
         #ifdef DEBUG
         cout<<endl<< "TP:     "<<TP<<"        TN:     "<<TN<<"        FP:     "<<FP<<"        FN:     "<<FN<<endl;
         cout << "Sensitivity: ("<<100*((double)TP/(double)(TP+FN))<<"%)"<<endl;
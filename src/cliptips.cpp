@@ -28,42 +28,139 @@ bool DBGraph::clipTips(int round)
 {
         cout <<endl<< " =================== Removing tips ===================" << endl;
 
-#ifdef DEBUG
-        size_t tp=0, tn=0, fp=0,fn=0;
-        size_t tps=0, tns=0, fps=0,fns=0;
-        size_t tpj=0, tnj=0, fpj=0,fnj=0;
-#endif
-
         size_t numDeleted = 0, numTotal = 0;
         cout << "Cut-off value for removing tips is: " << redLineValueCov << endl;
-        double threshold = redLineValueCov;
 
-        for (NodeID id = 1; id <= numNodes; id++) {
+        // get the node from which a tip should be inspected and classify it
+        auto getTipStart = [&](NodeID id, bool& isolated, bool& joinedTip) {
                 SSNode node = getSSNode(id);
-                if (!node.isValid())
-                        continue;
-                numTotal++;
 
                 // check for dead ends
                 bool leftDE = (node.getNumLeftArcs() == 0);
                 bool rightDE = (node.getNumRightArcs() == 0);
-                if (!leftDE && !rightDE)
-                        continue;
 
                 SSNode startNode = (rightDE) ? getSSNode(-id) : getSSNode(id);
-                bool isolated = rightDE && leftDE;
-                bool joinedTip = startNode.getNumRightArcs() > 1;
-                if (isolated||joinedTip)
-                        threshold=this->safeValueCov;
-                bool remove = false;
-                if ((startNode.getNodeKmerCov() <threshold) &&
-                    (startNode.getMarginalLength() < maxNodeSizeToDel))
-                        remove = removeNode(startNode);
-
-                if (remove)
-                        numDeleted++;
+                isolated = rightDE && leftDE;
+                joinedTip = startNode.getNumRightArcs() > 1;
+                return startNode;
+        };
+
+        auto isTip = [&](NodeID id) {
+                const DSNode& node = getDSNode(id);
+                return node.isValid() && ((node.getNumLeftArcs() == 0) ||
+                                          (node.getNumRightArcs() == 0));
+        };
+
+        auto isSafeTip = [&](NodeID id) {
+                if (!isTip(id))
+                        return false;
+                bool isolated, joinedTip;
+                getTipStart(id, isolated, joinedTip);
+                return isolated || joinedTip;
+        };
+
+        // only nodes that changed since the previous run can become tips
+        vector<NodeID> worklist;
+        bool incremental = getWorklist(clipTipsState, {redLineValueCov,
+                safeValueCov, (double)maxNodeSizeToDel}, worklist);
+
+        // the red line applies up to the first isolated node or joined tip,
+        // from that node on the (lower) safe value is used
+        const size_t numThreads = settings.getNumThreads();
+        NodeID firstSafeID = numNodes + 1;
+        if (incremental) {
+                // only changed nodes can become or stop being a safe tip
+                NodeID prevFirstSafeID = clipTipsFirstSafeID;
+                for (NodeID id : worklist) {
+                        if (id >= prevFirstSafeID)
+                                break;
+                        if (isSafeTip(id)) {
+                                firstSafeID = id;
+                                break;
+                        }
+                }
+
+                // if the previous first safe node is gone, continue the
+                // search from there on
+                if (firstSafeID > numNodes && prevFirstSafeID <= numNodes) {
+                        for (NodeID id = prevFirstSafeID; id <= numNodes; id++) {
+                                if (isSafeTip(id)) {
+                                        firstSafeID = id;
+                                        break;
+                                }
+                        }
+                }
+
+                // tips in [prevFirstSafeID, firstSafeID) are now judged
+                // against the red line: they must be revisited
+                if (firstSafeID > prevFirstSafeID) {
+                        if (firstSafeID - prevFirstSafeID > numNodes / 8) {
+                                incremental = false;
+                        } else {
+                                for (NodeID id = prevFirstSafeID; id < firstSafeID; id++)
+                                        worklist.push_back(id);
+                                sort(worklist.begin(), worklist.end());
+                                worklist.erase(unique(worklist.begin(),
+                                        worklist.end()), worklist.end());
+                        }
+                }
+        } else {
+                vector<NodeID> threadFirstSafe(numThreads, numNodes + 1);
+                parallelFor(1, numNodes + 1, [&](size_t threadID, size_t i) {
+                        NodeID id = i;
+                        if (id < threadFirstSafe[threadID] && isSafeTip(id))
+                                threadFirstSafe[threadID] = id;
+                });
+
+                for (size_t i = 0; i < numThreads; i++)
+                        firstSafeID = min(firstSafeID, threadFirstSafe[i]);
+        }
+        clipTipsFirstSafeID = firstSafeID;
+
+        // decide if a node with a dead end should be clipped
+        auto checkTip = [&](NodeID id, bool& isolated, bool& joinedTip) {
+                SSNode startNode = getTipStart(id, isolated, joinedTip);
+                double threshold = (id >= firstSafeID) ?
+                        safeValueCov : redLineValueCov;
+
+                return (startNode.getNodeKmerCov() < threshold) &&
+                       (startNode.getMarginalLength() < maxNodeSizeToDel);
+        };
+
+        size_t numCandidates = (incremental) ? worklist.size() : numNodes;
+        auto getCandidate = [&](size_t i) {
+                return (incremental) ? worklist[i] : NodeID(i + 1);
+        };
+
+        // mark the tips in parallel, all decisions are based on the same graph
+        vector<vector<NodeID> > victims(numThreads);
+        vector<size_t> threadTotal(numThreads, 0);
+        parallelFor(0, numCandidates, [&](size_t threadID, size_t i) {
+                NodeID id = getCandidate(i);
+                if (!getDSNode(id).isValid())
+                        return;
+                threadTotal[threadID]++;
+
+                bool isolated, joinedTip;
+                if (isTip(id) && checkTip(id, isolated, joinedTip))
+                        victims[threadID].push_back(id);
+        });
+
+        for (size_t i = 0; i < numThreads; i++)
+                numTotal += threadTotal[i];
 
 #ifdef DEBUG
+        size_t tp=0, tn=0, fp=0,fn=0;
+        size_t tps=0, tns=0, fps=0,fns=0;
+        size_t tpj=0, tnj=0, fpj=0,fnj=0;
+
+        for (size_t i = 0; i < numCandidates; i++) {
+                NodeID id = getCandidate(i);
+                if (!isTip(id))
+                        continue;
+
+                bool isolated, joinedTip;
+                bool remove = checkTip(id, isolated, joinedTip);
 
                 if (remove) {
                         if (trueMult.size()>0&& trueMult[id] > 0) {
@@ -98,10 +195,14 @@ bool DBGraph::clipTips(int round)
                                         fn++;
                         }
                 }
-#endif
         }
+#endif
+
+        // remove the marked tips
+        numDeleted = removeNodes(victims);
 
-        cout << "Clipped " << numDeleted << "/" << numTotal << " nodes" << endl;
+        cout << "Clipped " << numDeleted << "/" << numTotal
+             << ((incremental) ? " changed" : "") << " nodes" << endl;
 #ifdef DEBUG
         cout << "****************************************" << endl;
         cout << "Isolated TP: " << tps << "\tTN: "<< tns << "\tFP: " << fps << "\tFN: "<< fns << endl;
@@ -108,6 +108,9 @@ void DBGraph::countNodeandArcFrequency(LibraryContainer &inputs)
         inputs.joinIOThreads();
 
         depopulateTable();
+
+        // the node coverages changed
+        nodeStatsValid = false;
 }
 
 // ============================================================================
@@ -117,12 +120,6 @@ void DBGraph::countNodeandArcFrequency(LibraryContainer &inputs)
 //comment by mahdi
 
 
-bool cmssn(const SSNode& first, const SSNode & second ) {
-
-    return first.getMarginalLength()>second.getMarginalLength();
-
-
-}
 /**
  * this routine do the following things
  * 1. calculation of avg and std of node kmer coverage
@@ -131,115 +128,86 @@ bool cmssn(const SSNode& first, const SSNode & second ) {
  * 4. for every node it calculates the certainity of our guess about MULTIPLICITY
  * 5. for every node it calculates the inCorrctnessRatio of our guess about MULTIPLICITY
  *
+ * the averages are taken over the longest nodes that make up 5% of the
+ * graph, they are obtained from the length histogram of the node statistics
  */
 
 
 void DBGraph::extractStatistic(int round) {
-        vector <SSNode> nodeArray;
+        const map<size_t, LengthBin>& stats = getNodeStats();
         int percentage=5;
         double sumOfReadStcov=0;
         size_t totalLength=0;
         double StandardErrorMean=0;
         double avg=0;
-        for ( NodeID lID = 1; lID <= numNodes; lID++ ) {
-
-                SSNode node = getSSNode ( lID );
-                if(node.isValid() && node.getMarginalLength()) {
-                        totalLength=totalLength+node.getMarginalLength();
-                        nodeArray.push_back(node);
-
-                }
+        for (auto it : stats)
+                totalLength=totalLength+it.first*it.second.count;
 
-        }
-        sort(nodeArray.begin(), nodeArray.end(),cmssn );
-        size_t i=0;
         double sumOfCoverage=0;
+        double sumOfCoverageSq=0;
+        double sumOfNodeCoverage=0;
         double sumOfMarginalLenght=0;
+        double num=0;
 
         double sizeLimit=0;
         sizeLimit= (totalLength*percentage)/100;
-        /*if (settings.getGenomeSize()>0)
-                sizeLimit=((totalLength*percentage)/100)>settings.getGenomeSize()?settings.getGenomeSize():((totalLength*percentage)/100);
-        else
-                sizeLimit= (totalLength*percentage)/100;*/
-        while(sumOfMarginalLenght<sizeLimit) {
-                SSNode tempNode=nodeArray[i];
-                sumOfMarginalLenght=sumOfMarginalLenght+tempNode.getMarginalLength();
-                sumOfReadStcov=sumOfReadStcov+tempNode.getReadStartCov();
-                sumOfCoverage=sumOfCoverage+  tempNode.getKmerCov();  //tempNode.getExpMult();
-                i++;
+        for (auto it = stats.rbegin(); it != stats.rend(); it++) {
+                if (sumOfMarginalLenght>=sizeLimit || it->first==0)
+                        break;
+                const LengthBin& bin = it->second;
+                double margLength = it->first;
+
+                // nodes of equal length are interchangeable: if only part
+                // of the last bin is needed, take that fraction of its sums
+                double needed = ceil((sizeLimit-sumOfMarginalLenght)/margLength);
+                double fraction = needed < bin.count ? needed/bin.count : 1.0;
+
+                num=num+fraction*bin.count;
+                sumOfMarginalLenght=sumOfMarginalLenght+fraction*bin.count*margLength;
+                sumOfReadStcov=sumOfReadStcov+fraction*bin.readStartCov;
+                sumOfCoverage=sumOfCoverage+fraction*bin.kmerCov;
+                sumOfNodeCoverage=sumOfNodeCoverage+fraction*bin.kmerCov/margLength;
+                sumOfCoverageSq=sumOfCoverageSq+fraction*bin.kmerCovSq/(margLength*margLength);
         }
         avg=sumOfReadStcov/sumOfMarginalLenght;
         estimatedKmerCoverage=(sumOfCoverage/sumOfMarginalLenght);
-        size_t num=i;
-        double sumOfSTD=0;
-        i=0;
-        while(i<num) {
-                SSNode tempNode=nodeArray[i];
-                sumOfSTD=sumOfSTD+((tempNode.getNodeKmerCov())-estimatedKmerCoverage)*((tempNode.getNodeKmerCov())-estimatedKmerCoverage);
-                i++;
-        }
+
+        // sum of (nodeKmerCov - mean)^2 over the selected nodes
+        double sumOfSTD=sumOfCoverageSq-2*estimatedKmerCoverage*sumOfNodeCoverage
+                        +num*estimatedKmerCoverage*estimatedKmerCoverage;
         if(num>0)
-                StandardErrorMean=sqrt( sumOfSTD/num);
+                StandardErrorMean=sqrt(max(sumOfSTD, 0.0)/num);
         if (round==0)
                 estimatedMKmerCoverageSTD=StandardErrorMean;//          sqrt(num)*std;
 
-        for ( NodeID lID = 1; lID <= numNodes; lID++ ) {
-
+        // estimate the multiplicities in parallel, collect them afterwards
+        vector<pair_k> estimates(numNodes+1);
+        parallelFor(1, numNodes+1, [&](size_t, size_t lID) {
                 SSNode node = getSSNode ( lID );
                 if (!node.isValid())
-                        continue;
-                int nodeMultiplicity=1;
-                double maxProb=0;
-                double newValue=avg*nodeMultiplicity*node.getMarginalLength();
-                double newProbability=Util::poissonPDF(node.getReadStartCov(),newValue);
-                while(newProbability>maxProb) {
-                        nodeMultiplicity++;
-                        maxProb=newProbability;
-                        newValue=avg*nodeMultiplicity*node.getMarginalLength();
-                        newProbability=Util::poissonPDF(node.getReadStartCov(),newValue);
-                }
-
-                nodeMultiplicity--;
-
-                double denominator=0;
-                double currentProb=maxProb;
-
-                int i = 1;
-                bool minus=true;
-                do{
-                        currentProb=newProbability;
-                        double newValue=0;
-                        if (minus&& nodeMultiplicity>i){
-                                newValue=avg*(nodeMultiplicity-i)*node.getMarginalLength();
-                                minus=false;
-                        }
-                        else{
-                                newValue=avg*(nodeMultiplicity+i)*node.getMarginalLength();
-                                minus=true;
-                                i++;
-                        }
-                        newProbability=Util::poissonPDF(node.getReadStartCov(),newValue);
-                        denominator=denominator+newProbability;
-                }while(abs(newProbability-currentProb)> .000001|| i<5);
-                double confidenceRatio=maxProb/denominator;
-
-                double expectToSee=avg*nodeMultiplicity*node.getMarginalLength();
-                double observedprob=0;
-                if(node.getReadStartCov()<expectToSee)
-                        observedprob=Util::poissonPDF(node.getReadStartCov(),expectToSee);
-                else
-                        observedprob=Util::poissonPDF(expectToSee,expectToSee);
-                double inCorrctnessRatio=Util::poissonPDF(expectToSee,expectToSee)/observedprob;
-                SSNode reverseNode=getSSNode(-node.getNodeID());
-                reverseNode.setExpMult(nodeMultiplicity);
+                        return;
+                double confidenceRatio=0, inCorrctnessRatio=0;
+                int nodeMultiplicity=Util::estimateMultiplicity(node.getReadStartCov(),
+                                                                avg*node.getMarginalLength(),
+                                                                confidenceRatio, inCorrctnessRatio);
                 node.setExpMult(nodeMultiplicity);
-                nodesExpMult[abs(node.getNodeID())]=make_pair(nodeMultiplicity,make_pair( confidenceRatio,inCorrctnessRatio));
-
+                estimates[lID]=make_pair(nodeMultiplicity,make_pair( confidenceRatio,inCorrctnessRatio));
+        });
 
+        // the node identifiers are increasing: merge them into the map
+        map<NodeID, pair_k>::iterator hint = nodesExpMult.begin();
+        for ( NodeID lID = 1; lID <= numNodes; lID++ ) {
+                if (!getDSNode(lID).isValid())
+                        continue;
+                while (hint != nodesExpMult.end() && hint->first < lID)
+                        hint++;
+                if (hint != nodesExpMult.end() && hint->first == lID)
+                        hint->second=estimates[lID];
+                else
+                        hint=nodesExpMult.insert(hint, make_pair(lID, estimates[lID]));
         }
-
 }
+
 /**
  * this routine is used to check if the currNode can be a parallel path to some other nodes
  * the root node is also given.
@@ -286,9 +254,12 @@ bool DBGraph::nodeIsBubble(SSNode rootNode, SSNode currNode){
 bool DBGraph::checkNodeIsReliable(SSNode node){
         if (node.getMarginalLength()< Kmer::getK()) // smaller nodes might not be correct, these ndoes can never be deleted
                 return false;
-        pair<int, pair<double,double> > result=nodesExpMult[abs( node.getNodeID())];
-        double confidenceRatio=result.second.first;
-        double inCorrctnessRatio=result.second.second;
+        // read-only lookup: this routine is called from several threads
+        map<NodeID, pair_k>::const_iterator e = nodesExpMult.find(abs(node.getNodeID()));
+        if (e == nodesExpMult.end())
+                return false;
+        double confidenceRatio=e->second.second.first;
+        double inCorrctnessRatio=e->second.second.second;
         if (node.getNumRightArcs()<2)
                 return false;
         if (1/confidenceRatio>.001)
@@ -312,63 +283,65 @@ bool DBGraph::deleteUnreliableNodes(){
       return (changeIn1||changeIn2);
 }
 bool DBGraph::deleteExtraAttachedNodes(){
-        double tp=0, tn=0, fp=0,fn=0;
-        size_t numOfDel=0;
-        for ( NodeID lID =-numNodes; lID <= numNodes; lID++ ) {
-                if (lID % OUTPUT_FREQUENCY == 0)
-                        (cout << "Extracting node -" <<numNodes<< "/ "<<lID<<" /"<<numNodes
-                        << " from graph        \r").flush();
-                if (lID==0)
-                        continue;
+        const size_t numThreads = settings.getNumThreads();
+        vector<vector<NodeID> > victims(numThreads);
+        #ifdef DEBUG
+        vector<size_t> tp(numThreads, 0), tn(numThreads, 0), fp(numThreads, 0), fn(numThreads, 0);
+        #endif
+
+        // mark: a reliable node marks its first right neighbour if that one
+        // has a low coverage
+        auto markExtraNode = [&](size_t threadID, NodeID lID) {
                 SSNode node = getSSNode ( lID );
 
                 if(!node.isValid())
-                        continue;
+                        return;
                 if (!checkNodeIsReliable(node))
-                        continue;
+                        return;
                 if(node.getExpMult()<node.getNumRightArcs())
-                        continue;
-
-                ArcIt it = node.rightBegin();
-                SSNode currNode = getSSNode(it->getNodeID());
-                while(it != node.rightEnd()) {
-                        bool tip=currNode.getNumRightArcs()==0&&currNode.getNumLeftArcs()==1;
-                        SSNode firstNodeInUpPath;
-                        SSNode firstNodeInDoPath;
-                        bool bubble=nodeIsBubble(node,currNode);
-                        double threshold=(!tip&& !bubble)? this->redLineValueCov:(this->estimatedKmerCoverage-this->estimatedMKmerCoverageSTD*2>this->redLineValueCov)?this->estimatedKmerCoverage-this->estimatedMKmerCoverageSTD*2:this->redLineValueCov;
-                        if (currNode.getNodeKmerCov()<threshold &&removeNode(currNode)){
-                                #ifdef DEBUG
-                                if (trueMult[abs(currNode.getNodeID())]>0 ){
-                                        fp++;
-                                }
-                                else{
-                                        tp++;
-                                }
-                                #endif
-                                numOfDel++;
-                                break;
-                        }
-                        else{
-                                #ifdef DEBUG
-                                if (trueMult[abs(currNode.getNodeID())]>0){
-                                        tn++;
-                                }
-                                else{
-                                        fn++;
-                                }
-                                #endif
-                        }
-                        it++;
+                        return;
+
+                SSNode currNode = getSSNode(node.rightBegin()->getNodeID());
+                bool tip=currNode.getNumRightArcs()==0&&currNode.getNumLeftArcs()==1;
+                bool bubble=nodeIsBubble(node,currNode);
+                double threshold=(!tip&& !bubble)? this->redLineValueCov:(this->estimatedKmerCoverage-this->estimatedMKmerCoverageSTD*2>this->redLineValueCov)?this->estimatedKmerCoverage-this->estimatedMKmerCoverageSTD*2:this->redLineValueCov;
+                if (currNode.getNodeKmerCov()<threshold &&
+                    currNode.getMarginalLength()<=maxNodeSizeToDel){
+                        victims[threadID].push_back(currNode.getNodeID());
+                        #ifdef DEBUG
+                        if (trueMult[abs(currNode.getNodeID())]>0 )
+                                fp[threadID]++;
+                        else
+                                tp[threadID]++;
+                        #endif
+                        return;
                 }
-        }
-        cout<<endl;
+                #ifdef DEBUG
+                if (trueMult[abs(currNode.getNodeID())]>0)
+                        tn[threadID]++;
+                else
+                        fn[threadID]++;
+                #endif
+        };
+
+        parallelFor(1, numNodes + 1, [&](size_t threadID, size_t id) {
+                markExtraNode(threadID, id);
+                markExtraNode(threadID, -(NodeID)id);
+        });
+
+        // sweep
+        size_t numOfDel = removeNodes(victims);
+
         if (numOfDel>0)
                 cout << "Number of deleted nodes in deleteExtraAttachedNodes: " << numOfDel << endl;
         #ifdef DEBUG
-        cout<< "TP:     "<<tp<<"        TN:     "<<tn<<"        FP:     "<<fp<<"        FN:     "<<fn<<endl;
-        cout << "Sensitivity: ("<<100*((double)tp/(double)(tp+fn))<<"%)"<<endl;
-        cout<<"Specificity: ("<<100*((double)tn/(double)(tn+fp))<<"%)"<<endl;
+        double TP = 0, TN = 0, FP = 0, FN = 0;
+        for (size_t i = 0; i < numThreads; i++) {
+                TP += tp[i]; TN += tn[i]; FP += fp[i]; FN += fn[i];
+        }
+        cout<< "TP:     "<<TP<<"        TN:     "<<TN<<"        FP:     "<<FP<<"        FN:     "<<FN<<endl;
+        cout << "Sensitivity: ("<<100*(TP/(TP+FN))<<"%)"<<endl;
+        cout<<"Specificity: ("<<100*(TN/(TN+FP))<<"%)"<<endl;
         #endif
         return (numOfDel>0);
 }
@@ -445,84 +418,170 @@ bool DBGraph::connectSameMulNodes(){
 
 
 
+bool DBGraph::getMergeableRight(NodeID nodeID, bool force,
+                                NodeID &rightID) const
+{
+        SSNode node = getSSNode(nodeID);
+        if (!node.isValid() || node.getNumRightArcs() != 1)
+                return false;
+
+        // don't merge palindromic repeats or self-loops
+        rightID = node.rightBegin()->getNodeID();
+        if (abs(rightID) == abs(nodeID))
+                return false;
+
+        SSNode right = getSSNode(rightID);
+        if (right.getNumLeftArcs() != 1)
+                return false;
+
+        if (!force && (node.getNodeKmerCov() < cutOffvalue ||
+                       right.getNodeKmerCov() < cutOffvalue))
+                return false;
+
+        return true;
+}
+
 /**
  * merge single nodes together if they have only one ingoing and only one outgoin Arc
  * node kmer coverage and start read coverage should be updated after deleting the node
+ *
+ * Maximal non-branching chains are detected in parallel: a chain starts at a
+ * node without a mergeable left neighbour and is reported only in the
+ * orientation where its first node has the smallest identifier. Every chain
+ * is then merged into its first node in a single step. Cycles without such a
+ * starting node are left untouched.
  * @return true if they merge any nodes.
  *
  */
 bool DBGraph::mergeSingleNodes(bool force)
 {
-        size_t numDeleted = 0;
-        size_t numOfIncorrectConnection=0;
-        //comment by mahdi
-        //the initial was lID=1
-        bool change=false;//  deleteSuspiciousNodes();
-        for ( NodeID lID = -numNodes; lID <= numNodes; lID++ ) {
-                if ( lID == 0 ) {
-                        continue;
-                }
-                SSNode left = getSSNode ( lID );
-                if ( !left.isValid() ) {
-                        continue;
-                }
-                if ( left.getNumRightArcs() != 1 ) {
-                        continue;
-                }
-                //the previous one
-                NodeID rID = left.rightBegin()->getNodeID();
+        // only chains through nodes that changed since the previous run can
+        // be merged, the others were merged by that run
+        vector<NodeID> worklist;
+        bool incremental = getWorklist(mergeState[force], {(force) ? 0.0 :
+                cutOffvalue}, worklist);
+        size_t numCandidates = (incremental) ? worklist.size() : numNodes;
+
+        // find the chains: in a full sweep, every chain is found from its
+        // first node, else walk from a changed node to the first node
+        vector<vector<vector<NodeID> > > threadChains(settings.getNumThreads());
+        parallelFor(0, numCandidates, [&](size_t threadID, size_t i) {
+                NodeID id = (incremental) ? worklist[i] : NodeID(i + 1);
+                if (!getDSNode(id).isValid())
+                        return;
+
+                for (int strand = 0; strand < 2; strand++) {
+                        NodeID startID = (strand == 0) ? id : -id;
+                        NodeID headID = startID, rightID;
+                        if (incremental) {
+                                while (getMergeableRight(-headID, force, rightID)) {
+                                        headID = -rightID;
+                                        if (headID == startID)  // cycle
+                                                break;
+                                }
+                        }
+                        if (getMergeableRight(-headID, force, rightID))
+                                continue;
+                        if (!getMergeableRight(headID, force, rightID))
+                                continue;
 
-                // don't merge palindromic repeats
-                if ( rID == -lID ) {
-                        continue;
-                }
-                SSNode right = getSSNode ( rID );
-                if ( right.getNumLeftArcs() != 1 ) {
-                        continue;
+                        vector<NodeID> chain(1, headID);
+                        do {
+                                chain.push_back(rightID);
+                        } while (getMergeableRight(rightID, force, rightID));
+
+                        if (abs(chain.front()) < abs(chain.back()))
+                                threadChains[threadID].push_back(move(chain));
                 }
+        });
 
-                if (!force&& (left.getNodeKmerCov()<cutOffvalue || right.getNodeKmerCov()<cutOffvalue))
-                        continue;
+        vector<vector<NodeID> > chains;
+        for (size_t i = 0; i < threadChains.size(); i++)
+                for (size_t j = 0; j < threadChains[i].size(); j++)
+                        chains.push_back(move(threadChains[i][j]));
+        threadChains.clear();
 
-                #ifdef DEBUG
-                if (trueMult.size()>0)
-                if ( ( ( trueMult[abs ( lID )] >= 1 ) && ( trueMult[abs ( rID )] == 0 ) ) ||
-                        ( ( trueMult[abs ( rID )] >= 1 ) && ( trueMult[abs ( lID )] == 0 ) ) ){
-                                numOfIncorrectConnection++;
-                                trueMult[abs(lID)]=0;
-                                trueMult[abs(rID)]=0;
+        // process the chains in a fixed order for reproducible results
+        sort(chains.begin(), chains.end(),
+             [](const vector<NodeID>& a, const vector<NodeID>& b) {
+                return abs(a.front()) < abs(b.front()); });
+        chains.erase(unique(chains.begin(), chains.end()), chains.end());
 
+        #ifdef DEBUG
+        size_t numOfIncorrectConnection=0;
+        if (trueMult.size()>0)
+        for (size_t c = 0; c < chains.size(); c++) {
+                for (size_t i = 0; i + 1 < chains[c].size(); i++) {
+                        NodeID lID = chains[c][i], rID = chains[c][i+1];
+                        if ( ( ( trueMult[abs ( lID )] >= 1 ) && ( trueMult[abs ( rID )] == 0 ) ) ||
+                                ( ( trueMult[abs ( rID )] >= 1 ) && ( trueMult[abs ( lID )] == 0 ) ) ){
+                                        numOfIncorrectConnection++;
+                                        trueMult[abs(lID)]=0;
+                                        trueMult[abs(rID)]=0;
                         }
+                }
+        }
+        #endif
 
-                #endif
-
-                left.deleteRightArc ( rID );
-                right.deleteLeftArc ( lID );
-                left.inheritRightArcs ( right );
-                //left.setExpMult ( left.getExpMult() + right.getExpMult() );
-                left.setKmerCov(left.getKmerCov()+right.getKmerCov());
-                //comment by mahdi
-                left.setReadStartCov(left.getReadStartCov()+right.getReadStartCov());
-                right.invalidate();
-                numDeleted++;
+        // reserve arena space for the merged sequences
+        vector<size_t> offsets(chains.size()), lengths(chains.size());
+        for (size_t c = 0; c < chains.size(); c++) {
+                lengths[c] = getPathLength(chains[c]);
+                offsets[c] = arena.allocate(lengths[c]);
+                for (size_t i = 0; i < chains[c].size(); i++)
+                        removeNodeStats(chains[c][i]);
+        }
 
-                deque<SSNode> deq;
-                deq.push_back ( left );
-                deq.push_back ( right );
+        // concatenate the sequences, sum the coverage and remove the arcs
+        // inside the chains (each chain only touches its own nodes)
+        parallelFor(0, chains.size(), [&](size_t, size_t c) {
+                const vector<NodeID>& chain = chains[c];
+                writePathSequence(chain, offsets[c]);
+
+                Coverage kmerCov = 0, readStartCov = 0;
+                for (size_t i = 0; i < chain.size(); i++) {
+                        SSNode node = getSSNode(chain[i]);
+                        kmerCov += node.getKmerCov();
+                        readStartCov += node.getReadStartCov();
+                        if (i + 1 < chain.size()) {
+                                SSNode right = getSSNode(chain[i+1]);
+                                node.deleteRightArc(chain[i+1]);
+                                right.deleteLeftArc(chain[i]);
+                        }
+                }
 
-                string str;
-                convertNodesToString ( deq, str );
+                SSNode head = getSSNode(chain.front());
+                head.setKmerCov(kmerCov);
+                head.setReadStartCov(readStartCov);
+        });
 
-                left.setSequence ( str );
-                lID--;
+        // connect the first node to the right neighbours of the chain
+        size_t numDeleted = 0;
+        for (size_t c = 0; c < chains.size(); c++) {
+                const vector<NodeID>& chain = chains[c];
+                SSNode head = getSSNode(chain.front());
+                SSNode tail = getSSNode(chain.back());
+                head.inheritRightArcs(tail);
+                logNeighbourhood(chain.front());
+
+                for (size_t i = 1; i < chain.size(); i++) {
+                        DSNode& node = getDSNode(abs(chain[i]));
+                        node.invalidate();
+                        node.clearSequence();
+                }
 
+                arena.assign(abs(chain.front()), offsets[c], lengths[c]);
+                addNodeStats(chain.front());
+                numDeleted += chain.size() - 1;
         }
+        arena.reclaim();
+
         if (numDeleted>0)
         cout << "Concatenated " << numDeleted << " nodes" << endl;
         #ifdef DEBUG
         cout <<numOfIncorrectConnection<< " of connections are between correct and incorrect node"<<endl;
         #endif
-        return (numDeleted > 0||change);
+        return (numDeleted > 0);
 }
 
 
@@ -710,45 +769,45 @@ bool DBGraph::filterCoverage(float cutOff)
         cout << endl << " ================== Coverage Filter ==================" << endl;
 
         cout << "Cut-off value for removing nodes: " << cutOff << endl;
+
+        // the coverage of the remaining nodes does not change by removing
+        // nodes: mark all low coverage nodes first and remove them at once
+        auto isFiltered = [&](NodeID id) {
+                SSNode n = getSSNode(id);
+                return (n.getNodeKmerCov() <= cutOff) &&
+                       (n.getMarginalLength() <= maxNodeSizeToDel);
+        };
+
+        vector<vector<NodeID> > victims(settings.getNumThreads());
+        parallelFor(1, numNodes + 1, [&](size_t threadID, size_t id) {
+                if (getDSNode(id).isValid() && isFiltered(id))
+                        victims[threadID].push_back(id);
+        });
+
+        #ifdef DEBUG
         int tp=0;
         int tn=0;
         int fp=0;
         int fn=0;
-        size_t numFiltered = 0;
         for (NodeID i =1; i <= numNodes; i++) {
-
-                SSNode n = getSSNode(i);
-                if(!n.isValid())
-                        continue;
-                if (n.getNodeKmerCov()>cutOff) {
-                        #ifdef DEBUG
-                        if (trueMult.size()>0&& trueMult[abs(i)] >= 1)
-                                tn++;
-                        else
-                                fn++;
-                        #endif
+                if (!getDSNode(i).isValid())
                         continue;
-                }
-                bool Del=removeNode(n);
-                if (Del){
-                        numFiltered++;
-                        #ifdef DEBUG
-                        if (trueMult.size()>0&& trueMult[abs(i)] >= 1)
+                bool correct = trueMult.size()>0 && trueMult[i] >= 1;
+                if (isFiltered(i)) {
+                        if (correct)
                                 fp++;
                         else
                                 tp++;
-                        #endif
-                }
-                else
-                {
-                        #ifdef DEBUG
-                        if (trueMult[abs(i)] >= 1)
+                } else {
+                        if (correct)
                                 tn++;
                         else
                                 fn++;
-                        #endif
                 }
         }
+        #endif
+
+        size_t numFiltered = removeNodes(victims);
         cout << "Number of nodes deleted based on coverage: " << numFiltered<<endl;
         #ifdef DEBUG
         cout << " Gain value is ("<<100*((double)(tp-fp)/(double)(tp+fn))<< "%)"<<endl;
@@ -770,6 +829,7 @@ bool DBGraph::filterCoverage(float cutOff)
 bool DBGraph::removeNode(SSNode & rootNode) {
         if (rootNode.getMarginalLength()>maxNodeSizeToDel)
                 return false;
+        logNeighbourhood(rootNode.getNodeID());
         for ( ArcIt it2 = rootNode.leftBegin(); it2 != rootNode.leftEnd(); it2++ ) {
                 SSNode llNode = getSSNode ( it2->getNodeID() );
                 if (llNode.getNodeID()==-rootNode.getNodeID())
@@ -786,6 +846,55 @@ bool DBGraph::removeNode(SSNode & rootNode) {
         }
         rootNode.deleteAllRightArcs();
         rootNode.deleteAllLeftArcs();
+        removeNodeStats(rootNode.getNodeID());
         rootNode.invalidate();
         return true;
 }
+
+size_t DBGraph::removeNodes(const vector<vector<NodeID> >& nodeIDs)
+{
+        size_t numRemoved = 0;
+        vector<bool> marked(numNodes + 1, false);
+        for (size_t i = 0; i < nodeIDs.size(); i++) {
+                for (size_t j = 0; j < nodeIDs[i].size(); j++) {
+                        NodeID id = abs(nodeIDs[i][j]);
+                        if (marked[id] || !getDSNode(id).isValid())
+                                continue;
+                        marked[id] = true;
+                        logNeighbourhood(id);
+                        removeNodeStats(id);
+                        numRemoved++;
+                }
+        }
+
+        if (numRemoved == 0)
+                return 0;
+
+        parallelFor(1, numNodes + 1, [&](size_t, size_t id) {
+                DSNode& node = getDSNode(id);
+                if (!node.isValid())
+                        return;
+
+                if (marked[id]) {
+                        node.deleteLeftArcs();
+                        node.deleteRightArcs();
+                        node.invalidate();
+                        return;
+                }
+
+                // deleting an arc shifts the remaining arcs down
+                for (ArcIt it = node.leftBegin(); it != node.leftEnd(); )
+                        if (marked[abs(it->getNodeID())])
+                                node.deleteLeftArc(it->getNodeID());
+                        else
+                                it++;
+
+                for (ArcIt it = node.rightBegin(); it != node.rightEnd(); )
+                        if (marked[abs(it->getNodeID())])
+                                node.deleteRightArc(it->getNodeID());
+                        else
+                                it++;
+        });
+
+        return numRemoved;
+}
@@ -22,6 +22,9 @@
 #include "dsnode.h"
 
 Arc* DSNode::arcs = NULL;
+DSNode* DSNode::nodes = NULL;
+SequenceArena* DSNode::arena = NULL;
+NodeCov* DSNode::covs = NULL;
 
 bool DSNode::deleteLeftArc(NodeID targetID)
 {
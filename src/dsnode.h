@@ -26,6 +26,7 @@
 #include "arc.h"
 #include "tkmer.h"
 #include "tstring.h"
+#include "sequencearena.h"
 
 #include <map>
 #include <set>
@@ -38,24 +39,15 @@
 class ArcIt {
 
 private:
-        Arc* arcPtr;    // pointer to the positive arc
-        bool reversed;  // true if this is an arc from a RC node
-        Arc arc;        // arc copy, with nodeID sign swapped if necessary
-
-        void setArc() {
-                arc = *arcPtr;
-                if (reversed)
-                        arc.setNodeID(-arc.getNodeID());
-        }
+        const Arc* arcPtr;      // pointer to the positive arc
+        bool reversed;          // true if this is an arc from a RC node
 
 public:
         /**
          * Default constructor
          * @param id Identifier of the arc
          */
-        ArcIt(Arc *arcPtr, bool reversed) : arcPtr(arcPtr), reversed(reversed) {
-                setArc();
-        }
+        ArcIt(const Arc *arcPtr, bool reversed) : arcPtr(arcPtr), reversed(reversed) {}
 
         /**
          * Overloading of == operator
@@ -84,7 +76,6 @@ public:
         ArcIt operator++(int notused) {
                 ArcIt copy = *this;
                 arcPtr++;
-                setArc();
                 return copy;
         }
 
@@ -94,27 +85,65 @@ public:
          */
         ArcIt& operator++() {
                 arcPtr++;
-                setArc();
                 return *this;
         }
 
         /**
-         * Deference operator
-         * @return a reference to the arc
+         * Get the target nodeID, with the sign swapped if necessary
+         * @return The ID of the node the arc is pointing to
+         */
+        NodeID getNodeID() const {
+                NodeID nodeID = arcPtr->getNodeID();
+                return (reversed) ? -nodeID : nodeID;
+        }
+
+        /**
+         * Get the arc coverage
+         * @return The arc coverage
+         */
+        Coverage getCoverage() const {
+                return arcPtr->getCoverage();
+        }
+
+        /**
+         * Deference operator (the iterator itself acts as the arc view)
+         * @return a reference to the arc view
          */
-        const Arc& operator*() const {
-                return arc;
+        const ArcIt& operator*() const {
+                return *this;
         }
 
         /**
-         * Deference operator
-         * @return a reference to the arc
+         * Deference operator (the iterator itself acts as the arc view)
+         * @return a pointer to the arc view
          */
-        const Arc* operator->() const {
-                return &arc;
+        const ArcIt* operator->() const {
+                return this;
         }
 };
 
+// ============================================================================
+// NODE COVERAGE CLASS
+// ============================================================================
+
+/**
+ * Coverage and multiplicity information of a node. These fields are only
+ * used by the coverage routines, so they are stored in an array of their own,
+ * separate from the node topology that is read during every graph traversal.
+ */
+class NodeCov {
+
+public:
+        std::atomic<Coverage> readStartCov;
+        std::atomic<Coverage> kmerCov;
+        double expMult;
+
+        /**
+         * Default constructor
+         */
+        NodeCov() : readStartCov(0), kmerCov(0), expMult(0) {}
+};
+
 // ============================================================================
 // DOUBLE STRANDED NODE CLASS
 // ============================================================================
@@ -122,7 +151,10 @@ public:
 class DSNode {
 
 private:
-        static Arc* arcs;
+        static Arc* arcs;               // graph arcs
+        static DSNode* nodes;           // graph nodes (topology)
+        static SequenceArena* arena;    // node sequences, same indexing
+        static NodeCov* covs;           // node coverages, same indexing
 
         typedef union {
                 struct Packed {
@@ -134,15 +166,25 @@ private:
                 uint8_t up;
         } Bitfield;
 
-        TString sequence;       // DNA sequence
         ArcID leftID;           // ID of the first left arc or merged node
         ArcID rightID;          // ID of the first right arc or merged node
         Bitfield arcInfo;       // number of arcs at each node
 
-        double expMult;
+        /**
+         * Get the index of this node in the node arrays
+         * @return The index of this node
+         */
+        size_t index() const {
+                return this - nodes;
+        }
 
-        std::atomic<Coverage> readStartCov;
-        std::atomic<Coverage> kmerCov;
+        /**
+         * Get the coverage of this node in the coverage array
+         * @return Reference to the coverage information
+         */
+        NodeCov& cov() const {
+                return covs[index()];
+        }
 
 public:
         /**
@@ -153,10 +195,23 @@ public:
                 arcs = arcPtr;
         }
 
+        /**
+         * Set the static node pointers
+         * @param nodes_ Array of nodes (topology)
+         * @param arena_ Arena with the node sequences, indexed as the nodes
+         * @param covs_ Array of node coverages, indexed as the nodes
+         */
+        static void setNodePointers(DSNode *nodes_, SequenceArena *arena_,
+                                    NodeCov *covs_) {
+                nodes = nodes_;
+                arena = arena_;
+                covs = covs_;
+        }
+
         /**
          * Default constructor
          */
-        DSNode() : leftID(0), rightID(0), expMult(0), readStartCov(0), kmerCov(0) {
+        DSNode() : leftID(0), rightID(0) {
                 arcInfo.up = 0;
         }
 
@@ -165,7 +220,7 @@ public:
          * @param target The target multiplicity
          */
         void setExpMult(double target) {
-                expMult = target;
+                cov().expMult = target;
         }
 
         /**
@@ -173,7 +228,7 @@ public:
          * @return The expected multiplicity
          */
         double getExpMult() const {
-                return expMult;
+                return cov().expMult;
         }
 
         /**
@@ -181,7 +236,7 @@ public:
          * @param target The target read start coverage
          */
 	void setReadStartCov(Coverage target) {
-                readStartCov = target;
+                cov().readStartCov = target;
         }
 
         /**
@@ -189,14 +244,14 @@ public:
          * @return The read start coverage
          */
         Coverage getReadStartCov() const {
-                return readStartCov;
+                return cov().readStartCov;
         }
 
         /**
          * Atomically increment the read start coverage
          */
         void incReadStartCov() {
-                readStartCov++;
+                cov().readStartCov++;
         }
 
         /**
@@ -204,7 +259,7 @@ public:
          * @param target The kmer coverage
          */
         void setKmerCov(Coverage target) {
-                kmerCov = target;
+                cov().kmerCov = target;
         }
 
         /**
@@ -212,14 +267,14 @@ public:
          * @return The kmer coverage
          */
         Coverage getKmerCov() const {
-                return kmerCov;
+                return cov().kmerCov;
         }
 
         /**
          * Atomically increment the kmer coverage
          */
         void incKmerCov() {
-                kmerCov++;
+                cov().kmerCov++;
         }
 
         /**
@@ -227,7 +282,7 @@ public:
          * @return The multiplicity
          */
         size_t getRoundMult() const {
-                return (size_t)(expMult + 0.5);
+                return (size_t)(getExpMult() + 0.5);
         }
 
         /**
@@ -235,7 +290,7 @@ public:
          * @return The low side estimation of the multiplicity
          */
         size_t getLoExpMult() const {
-                int loSi = (int)(expMult - MULT_SIGN_STD * readStartCov + 0.5);
+                int loSi = (int)(getExpMult() - MULT_SIGN_STD * getReadStartCov() + 0.5);
                 return (loSi > 0) ? loSi : 0;
         }
 
@@ -244,7 +299,7 @@ public:
          * @return The high side estimation of the multiplicity
          */
         size_t getHiExpMult() const {
-                int hiSi = (int)(expMult + MULT_SIGN_STD * readStartCov + 0.5);
+                int hiSi = (int)(getExpMult() + MULT_SIGN_STD * getReadStartCov() + 0.5);
                 return hiSi;
         }
 
@@ -253,7 +308,7 @@ public:
          * @return True of false
          */
         bool multIsDubious() const {
-                return readStartCov < 1000;
+                return getReadStartCov() < 1000;
         }
 
         /**
@@ -334,7 +389,7 @@ public:
          * @return The length of the node
          */
         size_t getLength() const {
-                return sequence.getLength();
+                return arena->getLength(index());
         }
 
         /**
@@ -490,7 +545,7 @@ public:
          * @param str String containing only 'A', 'C', 'G' and 'T'
          */
         void setSequence(const std::string& str) {
-                sequence.setSequence(str);
+                arena->setSequence(index(), str);
         }
 
         /**
@@ -498,7 +553,7 @@ public:
          * @return The sequence of this node
          */
         std::string getSequence() const {
-                return sequence.getSequence();
+                return arena->getSequence(index());
         }
 
         /**
@@ -508,7 +563,40 @@ public:
          * @return stl string containing the sequence
          */
         std::string substr(size_t offset, size_t len) const {
-                return sequence.substr(offset, len);
+                return arena->substr(index(), offset, len);
+        }
+
+        /**
+         * Get the length of the common prefix of a subsequence and a
+         * packed string
+         * @param pos Start position in the (reverse complemented) sequence
+         * @param revCompl Use the reverse complement of the sequence
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param maxLen Maximum number of nucleotides to compare
+         * @return The number of matching nucleotides
+         */
+        size_t getMatchLength(size_t pos, bool revCompl,
+                              const PackedSequence& str, size_t strPos,
+                              size_t maxLen) const {
+                return arena->getMatchLength(index(), pos, revCompl, str,
+                                             strPos, maxLen);
+        }
+
+        /**
+         * Count the mismatches between a subsequence and a packed string
+         * @param pos Start position in the (reverse complemented) sequence
+         * @param revCompl Use the reverse complement of the sequence
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param len Number of nucleotides to compare
+         * @return The number of mismatches
+         */
+        size_t countMismatches(size_t pos, bool revCompl,
+                               const PackedSequence& str, size_t strPos,
+                               size_t len) const {
+                return arena->countMismatches(index(), pos, revCompl, str,
+                                              strPos, len);
         }
 
         /**
@@ -520,15 +608,14 @@ public:
                 // check for out-of-bounds
                 if (pos >= getLength())
                         return '-';
-                return sequence[pos];
+                return arena->getNucleotide(index(), pos);
         }
 
         /**
-         * Get the tight sequence of this node
-         * @return The tight sequence
+         * Clear the sequence of this node
          */
-        const TString& getTSequence() const {
-                return sequence;
+        void clearSequence() {
+                arena->clearSequence(index());
         }
 
         /**
@@ -536,7 +623,7 @@ public:
          * @return The leftmost nucleotide
          */
         char peekNucleotideLeft() const {
-                return sequence.peekNucleotideLeft();
+                return arena->getNucleotide(index(), 0);
         }
 
         /**
@@ -544,7 +631,7 @@ public:
          * @return The rightmost nucleotide
          */
         char peekNucleotideRight() const {
-                return sequence.peekNucleotideRight();
+                return arena->getNucleotide(index(), getLength() - 1);
         }
 
         /**
@@ -552,7 +639,7 @@ public:
          * @return The nucleotide at position k - 1
          */
         char peekNucleotideMarginalLeft() const {
-                return sequence.peekNucleotideMarginalLeft();
+                return arena->getNucleotide(index(), Kmer::getK() - 1);
         }
 
         /**
@@ -560,7 +647,7 @@ public:
          * @return The nucleotide at position size - k
          */
         char peekNucleotideMarginalRight() const {
-                return sequence.peekNucleotideMarginalRight();
+                return arena->getNucleotide(index(), getLength() - Kmer::getK());
         }
 
         /**
@@ -568,7 +655,7 @@ public:
          * @return The leftmost kmer
          */
         Kmer getLeftKmer() const {
-                return Kmer(sequence, 0);
+                return Kmer(arena->getBuffer(index()), 0);
         }
 
         /**
@@ -576,7 +663,7 @@ public:
          * @return The rightmost kmer
          */
         Kmer getRightKmer() const {
-                return Kmer(sequence, sequence.getLength() - Kmer::getK());
+                return Kmer(arena->getBuffer(index()), getLength() - Kmer::getK());
         }
 
         /**
@@ -593,7 +680,7 @@ public:
                 ofs.write((char*)&rightID, sizeof(rightID));
                 ofs.write((char*)&arcInfo, sizeof(arcInfo));
 
-                sequence.write(ofs);
+                arena->write(index(), ofs);
         }
 
         /**
@@ -613,7 +700,7 @@ public:
                 setKmerCov(kmerCov);
                 setReadStartCov(readStCov);
 
-                sequence.read(ifs);
+                arena->read(index(), ifs);
         }
 };
 
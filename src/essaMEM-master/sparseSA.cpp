@@ -6,6 +6,12 @@
 #include <assert.h>
 #include <string.h>
 #include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <atomic>
 
 #include "sparseSA.hpp"
 
@@ -21,7 +27,7 @@ sparseSA::sparseSA(string &S_, vector<string> const &descr_,
         bool suflink_, bool child_, bool kmer_,
         int sparseMult_, int kMerSize_, bool printSubstring_,
         bool printRevCompForw_, bool nucleotidesOnly_)
-      :        descr(descr_), startpos(startpos_), S(S_)
+      :        descr(descr_), startpos(startpos_), S(S_), mapAddr(NULL), mapLength(0)
 {
         _4column = __4column;
         hasChild = child_;
@@ -61,6 +67,11 @@ sparseSA::sparseSA(string &S_, vector<string> const &descr_,
         NKm1 = N/K-1;
 }
 
+sparseSA::~sparseSA() {
+        if (mapAddr != NULL)
+                munmap(mapAddr, mapLength);
+}
+
 // Uses the algorithm of Kasai et al 2001 which was described in
 // Manzini 2004 to compute the LCP array. Modified to handle sparse
 // suffix arrays and inverse sparse suffix arrays.
@@ -78,6 +89,23 @@ void sparseSA::computeLCP() {
         }
 }
 
+void sparseSA::computeLCP(long first, long last, vector<vec_uchar::item_t> &M) {
+        long h=0;
+        for (long i = first; i < last; i+=K) {
+                long m = ISA[i/K];
+                if (m==0) h = 0;
+                else {
+                        long j = SA[m-1];
+                        while (i+h < N && j+h < N && S[i+h] == S[j+h])        h++;
+                }
+                if (h >= numeric_limits<unsigned char>::max()) {
+                        LCP.vec[m] = numeric_limits<unsigned char>::max();
+                        M.push_back(vec_uchar::item_t(m, h));
+                } else LCP.vec[m] = (unsigned char)h;
+                h = max(0L, h - K);
+        }
+}
+
 // Child array construction algorithm
 void sparseSA::computeChild() {
         for (int i = 0; i < N/K; i++) {
@@ -124,6 +152,32 @@ void sparseSA::computeChild() {
         }
 }
 
+long sparseSA::kmerIndex(long pos) const {
+        if (pos + kMerSize > N) return kMerTableSize;
+        long index = 0;
+        for (long j = 0; j < kMerSize; j++) {
+                unsigned int b = BITADD[(unsigned char)S[pos+j]];
+                if (b == UINT_MAX) return kMerTableSize;
+                index = (index << 2) | b;
+        }
+        return index;
+}
+
+// Suffixes with the same kmer prefix are consecutive in SA: the thread
+// that holds the first (last) suffix of such a run sets left (right).
+void sparseSA::computeKmer(long first, long last) {
+        long prev = (first > 0) ? kmerIndex(SA[first-1]) : kMerTableSize;
+        long curr = kmerIndex(SA[first]);
+        for (long i = first; i < last; i++) {
+                long next = (i+1 < N/K) ? kmerIndex(SA[i+1]) : kMerTableSize;
+                if (curr < kMerTableSize) {
+                        if (curr != prev) KMR[curr].left = i;
+                        if (curr != next) KMR[curr].right = i;
+                }
+                prev = curr; curr = next;
+        }
+}
+
 // Look-up table construction algorithm
 void sparseSA::computeKmer() {
         stack<interval_t> intervalStack;
@@ -355,6 +409,155 @@ bool sparseSA::load(const string &prefix) {
         return true;
 }
 
+// Header of a memory mappable index file. The arrays SA, ISA, LCP.vec,
+// LCP.M, CHILD and KMR follow in this order, each at a multiple of 8 bytes.
+struct mapped_header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t saWidth; // bytes per suffix array element
+        uint64_t checksum;
+        int64_t N, K, logN, NKm1, kMerSize, kMerTableSize;
+        uint8_t hasSufLink, hasChild, hasKmer, pad[5];
+        uint64_t sizeSA, sizeISA, sizeLCP, sizeM, sizeCHILD, sizeKMR;
+};
+
+static const char MAPPED_MAGIC[8] = "ESSAMEM";
+static const uint32_t MAPPED_VERSION = 2;
+
+static size_t align8(size_t bytes) {
+        return (bytes + 7) & ~(size_t)7;
+}
+
+static uint64_t mix64(uint64_t h, uint64_t v) {
+        h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+}
+
+static void write_aligned(ofstream &ofs, const void *data, size_t bytes) {
+        static const char zeros[8] = {0};
+        if (bytes > 0)
+                ofs.write((const char*)data, bytes);
+        ofs.write(zeros, align8(bytes) - bytes);
+}
+
+uint64_t sparseSA::checksum() const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        size_t i = 0;
+        for (; i + 8 <= S.size(); i += 8) {
+                uint64_t w;
+                memcpy(&w, S.data() + i, 8);
+                h = mix64(h, w);
+        }
+        for (; i < S.size(); i++)
+                h = mix64(h, (unsigned char)S[i]);
+        for (size_t j = 0; j < startpos.size(); j++)
+                h = mix64(h, startpos[j]);
+        h = mix64(h, N);
+        h = mix64(h, K);
+        h = mix64(h, kMerSize);
+        return mix64(h, hasSufLink + 2 * hasChild + 4 * hasKmer);
+}
+
+bool sparseSA::saveMapped(const string &filename) const {
+        mapped_header_t h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, MAPPED_MAGIC, sizeof(h.magic));
+        h.version = MAPPED_VERSION;
+        h.saWidth = sizeof(SA[0]);
+        h.checksum = checksum();
+        h.N = N; h.K = K; h.logN = logN; h.NKm1 = NKm1;
+        h.kMerSize = kMerSize; h.kMerTableSize = hasKmer ? kMerTableSize : 0;
+        h.hasSufLink = hasSufLink; h.hasChild = hasChild; h.hasKmer = hasKmer;
+        h.sizeSA = SA.size(); h.sizeISA = ISA.size();
+        h.sizeLCP = LCP.vec.size(); h.sizeM = LCP.M.size();
+        h.sizeCHILD = CHILD.size(); h.sizeKMR = KMR.size();
+
+        string tmp = filename + ".tmp";
+        ofstream ofs(tmp.c_str(), ios::binary);
+        if (!ofs)
+                return false;
+        ofs.write((const char*)&h, sizeof(h));
+        write_aligned(ofs, SA.ptr, SA.size() * sizeof(SA[0]));
+        write_aligned(ofs, ISA.ptr, ISA.size() * sizeof(ISA[0]));
+        write_aligned(ofs, LCP.vec.ptr, LCP.vec.size() * sizeof(LCP.vec[0]));
+        write_aligned(ofs, LCP.M.data(), LCP.M.size() * sizeof(vec_uchar::item_t));
+        write_aligned(ofs, CHILD.ptr, CHILD.size() * sizeof(CHILD[0]));
+        write_aligned(ofs, KMR.ptr, KMR.size() * sizeof(KMR[0]));
+        ofs.close();
+
+        if (!ofs) {
+                remove(tmp.c_str());
+                return false;
+        }
+        return rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+bool sparseSA::loadMapped(const string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+                return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(mapped_header_t)) {
+                close(fd);
+                return false;
+        }
+
+        size_t length = st.st_size;
+        void *addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+                return false;
+
+        // validate the file against this text and these parameters
+        const mapped_header_t &h = *(const mapped_header_t*)addr;
+        bool valid = (memcmp(h.magic, MAPPED_MAGIC, sizeof(h.magic)) == 0) &&
+                     (h.version == MAPPED_VERSION) &&
+                     (h.saWidth == sizeof(SA[0])) &&
+                     (h.N == N) && (h.K == K) && (h.kMerSize == kMerSize) &&
+                     (h.hasSufLink == hasSufLink) && (h.hasChild == hasChild) &&
+                     (h.hasKmer == hasKmer) && (h.checksum == checksum());
+        if (valid) {
+                size_t expected = sizeof(h) +
+                        align8(h.sizeSA * sizeof(SA[0])) +
+                        align8(h.sizeISA * sizeof(ISA[0])) +
+                        align8(h.sizeLCP * sizeof(LCP.vec[0])) +
+                        align8(h.sizeM * sizeof(vec_uchar::item_t)) +
+                        align8(h.sizeCHILD * sizeof(CHILD[0])) +
+                        align8(h.sizeKMR * sizeof(KMR[0]));
+                valid = (expected == length);
+        }
+        if (!valid) {
+                munmap(addr, length);
+                return false;
+        }
+
+        if (mapAddr != NULL)
+                munmap(mapAddr, mapLength);
+        mapAddr = addr;
+        mapLength = length;
+
+        logN = h.logN;
+        NKm1 = h.NKm1;
+        kMerTableSize = h.kMerTableSize;
+
+        const char *p = (const char*)addr + sizeof(h);
+        SA.map((const unsigned int*)p, h.sizeSA);
+        p += align8(h.sizeSA * sizeof(SA[0]));
+        ISA.map((const int*)p, h.sizeISA);
+        p += align8(h.sizeISA * sizeof(ISA[0]));
+        LCP.vec.map((const unsigned char*)p, h.sizeLCP);
+        p += align8(h.sizeLCP * sizeof(LCP.vec[0]));
+        const vec_uchar::item_t *M = (const vec_uchar::item_t*)p;
+        LCP.M.assign(M, M + h.sizeM);
+        p += align8(h.sizeM * sizeof(vec_uchar::item_t));
+        CHILD.map((const int*)p, h.sizeCHILD);
+        p += align8(h.sizeCHILD * sizeof(CHILD[0]));
+        KMR.map((const saTuple_t*)p, h.sizeKMR);
+
+        return true;
+}
+
 void sparseSA::construct() {
         if (K > 1) {
                 long bucketNr = 1;
@@ -419,9 +622,7 @@ void sparseSA::construct() {
         computeLCP(); // SA + ISA -> LCP
         LCP.init();
         if (!hasSufLink) {
-                vector<int> tmp;
-                ISA.swap(tmp);
-        //ISA.clear();
+                ISA.clear();
         }
         if (hasChild) {
                 CHILD.resize(N/K);
@@ -439,6 +640,132 @@ void sparseSA::construct() {
 
 }
 
+// Orders suffixes of S lexicographically (a proper prefix comes first),
+// comparing from a given depth on.
+struct suffix_less_t {
+        const unsigned char *s; long N; long depth;
+        suffix_less_t(const string &S, long N_, long d) :
+                s((const unsigned char*)S.data()), N(N_), depth(d) {}
+        bool operator() (unsigned int a, unsigned int b) const {
+                long la = N - a - depth, lb = N - b - depth;
+                long l = min(la, lb);
+                if (l > 0) {
+                        int c = memcmp(s + a + depth, s + b + depth, l);
+                        if (c != 0) return c < 0;
+                }
+                return la < lb;
+        }
+};
+
+// Run f(first, last) on numThreads consecutive chunks of [0, n).
+template<class F>
+static void parallel_chunks(int numThreads, long n, long align, F f) {
+        long chunk = ((n + numThreads - 1) / numThreads + align - 1) / align * align;
+        vector<thread> workers;
+        for (long first = 0; first < n; first += chunk)
+                workers.push_back(thread(f, first, min(n, first + chunk)));
+        for (size_t i = 0; i < workers.size(); i++)
+                workers[i].join();
+}
+
+void sparseSA::sortSuffixes(int numThreads) {
+        long n = N/K;
+
+        // rank the characters, 0 is reserved for "past the end"
+        int char2int[UCHAR_MAX+1];
+        for (int i=0; i<=UCHAR_MAX; i++) char2int[i]=0;
+        for (long i = 0; i < N; i++) char2int[(unsigned char)S[i]]=1;
+        long sigma = 1;
+        for (int i=0; i <= UCHAR_MAX; i++)
+                if (char2int[i]) char2int[i] = sigma++;
+
+        // bucket the suffixes by their first depth characters
+        long depth = 0, numBuckets = 1;
+        while (numBuckets * sigma <= (1 << 16)) { numBuckets *= sigma; depth++; }
+
+        vector<unsigned int> key(n);
+        parallel_chunks(numThreads, n, 1, [&](long first, long last) {
+                for (long i = first; i < last; i++) {
+                        long pos = i * K, k = 0;
+                        for (long d = 0; d < depth; d++)
+                                k = k * sigma + ((pos + d < N) ? char2int[(unsigned char)S[pos + d]] : 0);
+                        key[i] = k;
+                }
+        });
+
+        vector<long> bucketBegin(numBuckets + 1, 0);
+        for (long i = 0; i < n; i++) bucketBegin[key[i] + 1]++;
+        for (long b = 0; b < numBuckets; b++) bucketBegin[b+1] += bucketBegin[b];
+
+        SA.resize(n);
+        vector<long> fill(bucketBegin.begin(), bucketBegin.end() - 1);
+        for (long i = 0; i < n; i++) SA[fill[key[i]]++] = (unsigned int)(i * K);
+        vector<unsigned int>().swap(key);
+
+        // sort the largest buckets first
+        vector<long> order;
+        for (long b = 0; b < numBuckets; b++)
+                if (bucketBegin[b+1] - bucketBegin[b] > 1) order.push_back(b);
+        sort(order.begin(), order.end(), [&](long a, long b) {
+                return bucketBegin[a+1] - bucketBegin[a] > bucketBegin[b+1] - bucketBegin[b];
+        });
+
+        atomic<size_t> next(0);
+        suffix_less_t less(S, N, depth);
+        parallel_chunks(numThreads, numThreads, 1, [&](long, long) {
+                for (size_t o = next++; o < order.size(); o = next++) {
+                        long b = order[o];
+                        sort(SA.ptr + bucketBegin[b], SA.ptr + bucketBegin[b+1], less);
+                }
+        });
+}
+
+void sparseSA::construct(int numThreads) {
+        if (numThreads <= 1) {
+                construct();
+                return;
+        }
+
+        sortSuffixes(numThreads);
+        long n = N/K;
+
+        ISA.resize(n);
+        parallel_chunks(numThreads, n, 1, [&](long first, long last) {
+                for (long i = first; i < last; i++) ISA[SA[i]/K] = i;
+        });
+
+        // every thread restarts Kasai with h = 0 at its first text position
+        LCP.resize(n);
+        vector<vector<vec_uchar::item_t> > M(numThreads);
+        atomic<int> chunkID(0);
+        parallel_chunks(numThreads, N, K, [&](long first, long last) {
+                computeLCP(first, last, M[chunkID++]);
+        });
+        for (int t = 0; t < numThreads; t++)
+                LCP.M.insert(LCP.M.end(), M[t].begin(), M[t].end());
+        LCP.init();
+
+        if (!hasSufLink)
+                ISA.clear();
+
+        // the child table is built while the other threads fill the kmer table
+        thread childThread;
+        if (hasChild) {
+                CHILD.resize(n);
+                childThread = thread(&sparseSA::computeChild, this);
+        }
+        if (hasKmer) {
+                kMerTableSize = 1 << (2*kMerSize);
+                KMR.resize(kMerTableSize, saTuple_t());
+                parallel_chunks(max(1, numThreads - (hasChild ? 1 : 0)), n, 1,
+                                [&](long first, long last) { computeKmer(first, last); });
+        }
+        if (hasChild)
+                childThread.join();
+
+        NKm1 = N/K-1;
+}
+
 // Implements a variant of American flag sort (McIlroy radix sort).
 // Recurse until big-K size prefixes are sorted. Adapted from the C++
 // source code for the wordSA implementation from the following paper:
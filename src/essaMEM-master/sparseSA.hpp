@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <limits>
 #include <limits.h>
+#include <stdint.h>
 
 
 using namespace std;
@@ -41,17 +42,39 @@ static const unsigned int BITADD[256] =
         UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX                                                 //250-255
 };
 
+// Array that either owns its elements (like a vector) or refers to
+// elements in a read-only memory mapped index file (see loadMapped).
+template<class T>
+struct mapped_vector {
+        vector<T> vec; // owned elements, empty if the array is mapped
+        T *ptr; // first element
+        size_t n; // number of elements
+
+        mapped_vector() : ptr(NULL), n(0) {}
+        mapped_vector(const mapped_vector&) = delete;
+        void operator=(const mapped_vector&) = delete;
+
+        void resize(size_t N, const T& v = T()) { vec.resize(N, v); ptr = vec.data(); n = N; }
+        void clear() { vector<T>().swap(vec); ptr = NULL; n = 0; }
+        // Refer to N elements stored elsewhere. They must outlive the array.
+        void map(const T *p, size_t N) { clear(); ptr = const_cast<T*>(p); n = N; }
+        size_t size() const { return n; }
+        size_t capacity() const { return vec.capacity(); }
+        T& operator[] (size_t idx) { return ptr[idx]; }
+        const T& operator[] (size_t idx) const { return ptr[idx]; }
+};
+
 // Stores the LCP array in an unsigned char (0-255). Values larger
 // than or equal to 255 are stored in a sorted array.
 // Simulates a vector<int> LCP;
 struct vec_uchar {
         struct item_t{
                 item_t(){}
-                item_t(size_t i, int v) { idx = i; val = v; }
-                size_t idx; int val;
+                item_t(size_t i, int v) { idx = (unsigned int)i; val = v; }
+                unsigned int idx; int val; // 32-bit, like the other index arrays
                 bool operator < (item_t t) const { return idx < t.idx; }
         };
-        vector<unsigned char> vec; // LCP values from 0-65534
+        mapped_vector<unsigned char> vec; // LCP values from 0-65534
         vector<item_t> M;
         void resize(size_t N) { vec.resize(N); }
         // Vector X[i] notation to get LCP values.
@@ -65,10 +88,10 @@ struct vec_uchar {
         // values.
         void set(size_t idx, int v) {
                 if(v >= numeric_limits<unsigned char>::max()) {
-                        vec.at(idx) = numeric_limits<unsigned char>::max();
+                        vec[idx] = numeric_limits<unsigned char>::max();
                         M.push_back(item_t(idx, v));
                 }
-                else { vec.at(idx) = (unsigned char)v; }
+                else { vec[idx] = (unsigned char)v; }
         }
         // Once all the values are set, call init. This will assure the
         // values >= 255 are sorted by index for fast retrieval.
@@ -77,7 +100,7 @@ struct vec_uchar {
         long index_size_in_bytes() const {
                 long indexSize = 0L;
                 indexSize += sizeof(vec) + vec.capacity()*sizeof(unsigned char);
-                indexSize += sizeof(M) + M.capacity()*(sizeof(size_t)+sizeof(int));
+                indexSize += sizeof(M) + M.capacity()*sizeof(item_t);
                 return indexSize;
         }
 };
@@ -117,11 +140,14 @@ struct sparseSA {
         long logN; // ceil(log(N))
         long NKm1; // N/K - 1
         string &S; //!< Reference to sequence data.
-        vector<unsigned int> SA; // Suffix array.
-        vector<int> ISA; // Inverse suffix array.
+        mapped_vector<unsigned int> SA; // Suffix array.
+        mapped_vector<int> ISA; // Inverse suffix array.
         vec_uchar LCP; // Simulates a vector<int> LCP.
-        vector<int> CHILD; //child table
-        vector<saTuple_t> KMR;
+        mapped_vector<int> CHILD; //child table
+        mapped_vector<saTuple_t> KMR;
+
+        void *mapAddr; // memory mapped index file (NULL if none)
+        size_t mapLength; // length of the memory mapping
 
         long K; // suffix sampling, K = 1 every suffix, K = 2 every other suffix, K = 3, every 3rd sffix
         bool hasChild;
@@ -155,7 +181,7 @@ struct sparseSA {
                 indexSize += sizeof(kMerSize);
                 indexSize += sizeof(kMerTableSize);
                 indexSize += sizeof(nucleotidesOnly);
-                for(int i = 0; i < descr.size(); i++){
+                for(size_t i = 0; i < descr.size(); i++){
                         indexSize += descr[i].capacity();
                 }
                 indexSize += sizeof(startpos) + startpos.capacity()*sizeof(long);
@@ -168,6 +194,14 @@ struct sparseSA {
                 return indexSize;
         }
 
+        // Maximum number of (sampled) suffixes: ISA, CHILD, KMR and the
+        // large LCP values use 32-bit (signed) integers.
+        static long max_num_suffixes() { return numeric_limits<int>::max(); }
+
+        // Maximum length of the concatenated text: SA stores text positions
+        // as 32-bit unsigned integers. Both limits must hold.
+        static long max_text_length() { return numeric_limits<unsigned int>::max(); }
+
         // Maps a hit in the concatenated sequence set to a position in that sequence.
         void from_set(long hit, long &seq, long &seqpos) const {
                 // Use binary search to locate index of sequence and position
@@ -183,12 +217,27 @@ struct sparseSA {
         bool __4column, long K_, bool suflink_, bool child_, bool kmer_, int sparseMult_,
         int kMerSize_, bool printSubstring_, bool printRevCompForw_, bool nucleotidesOnly_);
 
+        // Destructor unmaps the index file, if any.
+        ~sparseSA();
+
         // Modified Kasai et all for LCP computation.
         void computeLCP();
+        // Kasai for the text positions [first, last) only, LCP values
+        // >= 255 are appended to M instead of LCP.M.
+        void computeLCP(long first, long last, vector<vec_uchar::item_t> &M);
         //Modified Abouelhoda et all for CHILD Computation.
         void computeChild();
         //build look-up table for sa intervals of kmers up to some depth
         void computeKmer();
+        //same table, filled by a scan over SA positions [first, last)
+        void computeKmer(long first, long last);
+        //index of the kmer at the start of a suffix (kMerTableSize if none)
+        long kmerIndex(long pos) const;
+
+        // Sort the sparse suffixes in parallel: suffixes are distributed
+        // over buckets by their first characters, buckets are sorted
+        // independently by comparison.
+        void sortSuffixes(int numThreads);
 
         // Radix sort required to construct transformed text for sparse SA construction.
         void radixStep(int *t_new, int *SA, long &bucketNr, long *BucketBegin, long l, long r, long h);
@@ -282,8 +331,26 @@ struct sparseSA {
         //load index from file
         bool load(const string &prefix);
 
+        // Checksum of the indexed text, the sequence layout and the index
+        // parameters, used to validate an index file.
+        uint64_t checksum() const;
+
+        // Save the index to a single versioned file that can be memory
+        // mapped. The file is written under a temporary name and renamed
+        // when complete. Returns false on I/O errors.
+        bool saveMapped(const string &filename) const;
+
+        // Memory map an index file written by saveMapped instead of calling
+        // construct(). Returns false (and leaves the index empty) if the
+        // file is absent or does not match the version, text or parameters.
+        bool loadMapped(const string &filename);
+
         //construct
         void construct();
+
+        // Construct with multiple threads, the resulting index is identical
+        // to the one of construct().
+        void construct(int numThreads);
 };
 
 
@@ -34,7 +34,9 @@ const DBGraph* DBGraph::graph = NULL;
 
 
 DBGraph::DBGraph(const Settings& settings) : table(NULL), settings(settings),
-        nodes(NULL), arcs(NULL), numNodes(0), numArcs(0), mapType(SHORT_MAP) {
+        nodes(NULL), nodeCovs(NULL), arcs(NULL), numNodes(0), numArcs(0),
+        changeLogEpoch(1), clipTipsFirstSafeID(0), nodeStatsValid(false),
+        mapType(SHORT_MAP) {
     DBGraph::graph = this;
     //mahdi comment my
     initialize();
@@ -83,7 +85,8 @@ void DBGraph::graphPurification(string trueMultFilename,
         size_t increamentDepth = readLength;
         bool simplified = true;
         while (simplified ) {// &&
-                //
+                // drop the nodes and arcs removed in the previous round
+                compactGraph();
                 //*******************************************************
                 updateCutOffValue(round);
                 bool tips=clipTips(round);
@@ -297,6 +300,8 @@ void DBGraph::sanityCheck()
             if ((n.getNumLeftArcs() != 0) || (n.getNumRightArcs() != 0))
                 cerr << "\t\tNode " << n.getNodeID()
                      << " is invalid but has arcs." << endl;
+            // merged nodes no longer own a sequence
+            continue;
         }
         // check the continuity of the kmers
         Kmer firstKmer(sequence);
@@ -336,7 +341,279 @@ void DBGraph::sanityCheck()
 DBGraph::~DBGraph()
 {
     delete [] arcs;
+    freeNodes();
+}
+
+void DBGraph::allocateNodes(size_t expNumNucleotides)
+{
+    nodes = new DSNode[numNodes+1];
+    nodeCovs = new NodeCov[numNodes+1];
+    arena.reset(numNodes+1, expNumNucleotides);
+
+    SSNode::setNodePointer(nodes);
+    DSNode::setNodePointers(nodes, &arena, nodeCovs);
+
+    // a new graph: all purification passes start with a full sweep
+    changeLog.clear();
+    changeLogEpoch++;
+
+    nodeStats.clear();
+    nodeStatsValid = false;
+    origNodeID.clear();
+}
+
+void DBGraph::cloneTopology(const DBGraph& source)
+{
+    clear();
+    numNodes = source.numNodes;
+    numArcs = source.numArcs;
+
+    nodes = new DSNode[numNodes+1];
+    nodeCovs = new NodeCov[numNodes+1];
+    arcs = new Arc[numArcs+2];
+    copy(source.nodes, source.nodes + numNodes + 1, nodes);
+    copy(source.arcs, source.arcs + numArcs + 2, arcs);
+    for (NodeID id = 0; id <= numNodes; id++) {
+        nodeCovs[id].readStartCov = source.nodeCovs[id].readStartCov.load();
+        nodeCovs[id].kmerCov = source.nodeCovs[id].kmerCov.load();
+        nodeCovs[id].expMult = source.nodeCovs[id].expMult;
+    }
+    arena.cloneLengths(source.arena);
+
+#ifdef DEBUG
+    trueMult = source.trueMult;
+#endif
+
+    changeLog.clear();
+    changeLogEpoch++;
+    nodeStats.clear();
+    nodeStatsValid = false;
+    origNodeID = source.origNodeID;
+
+    setStaticPointers();
+}
+
+void DBGraph::setStaticPointers()
+{
+    DBGraph::graph = this;
+    SSNode::setNodePointer(nodes);
+    DSNode::setNodePointers(nodes, &arena, nodeCovs);
+    DSNode::setArcsPointer(arcs);
+}
+
+void DBGraph::logNeighbourhood(NodeID nodeID)
+{
+    SSNode node = getSSNode(nodeID);
+    logChange(nodeID);
+    for (ArcIt it = node.leftBegin(); it != node.leftEnd(); it++)
+        logChange(it->getNodeID());
+    for (ArcIt it = node.rightBegin(); it != node.rightEnd(); it++)
+        logChange(it->getNodeID());
+}
+
+bool DBGraph::getWorklist(PassState& state, const vector<double>& params,
+                          vector<NodeID>& worklist)
+{
+    // the log never grows beyond the size of the graph: when it is reset,
+    // all passes fall back to a full sweep
+    if (changeLog.size() > (size_t)numNodes) {
+        changeLog.clear();
+        changeLogEpoch++;
+    }
+
+    // a full sweep is cheaper when a large part of the graph changed
+    bool incremental = (state.epoch == changeLogEpoch) &&
+                       (state.params == params) &&
+                       (changeLog.size() - state.logPos <= (size_t)numNodes / 8);
+
+    worklist.clear();
+    if (incremental) {
+        worklist.assign(changeLog.begin() + state.logPos, changeLog.end());
+        sort(worklist.begin(), worklist.end());
+        worklist.erase(unique(worklist.begin(), worklist.end()), worklist.end());
+    }
+
+    // changes made by the pass itself are revisited during its next run
+    state.epoch = changeLogEpoch;
+    state.logPos = changeLog.size();
+    state.params = params;
+
+    return incremental;
+}
+
+void DBGraph::getLocalityOrder(vector<size_t>& order) const
+{
+    // seeds in order of decreasing kmer coverage (per nucleotide)
+    vector<NodeID> seeds;
+    for (NodeID id = 1; id <= numNodes; id++)
+        if (getDSNode(id).isValid())
+            seeds.push_back(id);
+
+    vector<double> cov(numNodes + 1, 0);
+    for (size_t i = 0; i < seeds.size(); i++) {
+        const DSNode& node = getDSNode(seeds[i]);
+        if (node.getMarginalLength() > 0)
+            cov[seeds[i]] = (double)node.getKmerCov() / node.getMarginalLength();
+    }
+    stable_sort(seeds.begin(), seeds.end(), [&](NodeID a, NodeID b) {
+        return cov[a] > cov[b]; });
+
+    // breadth-first search from every unvisited seed, order is the queue
+    vector<bool> visited(numNodes + 1, false);
+    order.assign(1, 0);
+    for (size_t i = 0; i < seeds.size(); i++) {
+        if (visited[seeds[i]])
+            continue;
+        visited[seeds[i]] = true;
+        size_t head = order.size();
+        order.push_back(seeds[i]);
+        for ( ; head < order.size(); head++) {
+            SSNode node = getSSNode(order[head]);
+            for (ArcIt it = node.leftBegin(); it != node.leftEnd(); it++)
+                if (!visited[abs(it->getNodeID())]) {
+                    visited[abs(it->getNodeID())] = true;
+                    order.push_back(abs(it->getNodeID()));
+                }
+            for (ArcIt it = node.rightBegin(); it != node.rightEnd(); it++)
+                if (!visited[abs(it->getNodeID())]) {
+                    visited[abs(it->getNodeID())] = true;
+                    order.push_back(abs(it->getNodeID()));
+                }
+        }
+    }
+}
+
+bool DBGraph::compactGraph()
+{
+    NodeID numValid = 0;
+    for (NodeID id = 1; id <= numNodes; id++)
+        if (getDSNode(id).isValid())
+            numValid++;
+
+    if (2 * (size_t)numValid > (size_t)numNodes)
+        return false;
+
+    // the valid nodes keep their relative order: chain orientation in
+    // mergeSingleNodes and bubble resolution depend on the node identifiers
+    vector<size_t> order(1, 0);
+    for (NodeID id = 1; id <= numNodes; id++)
+        if (getDSNode(id).isValid())
+            order.push_back(id);
+
+    NodeID prevNumNodes = numNodes;
+    ArcID prevNumArcs = numArcs;
+    renumberNodes(order);
+
+    cout << "Compacted graph from " << prevNumNodes << " to " << numNodes
+         << " nodes and from " << prevNumArcs << " to " << numArcs
+         << " arcs" << endl;
+    return true;
+}
+
+void DBGraph::reorderNodes()
+{
+    vector<size_t> order;
+    getLocalityOrder(order);
+    renumberNodes(order);
+}
+
+void DBGraph::renumberNodes(const vector<size_t>& order)
+{
+    vector<NodeID> newID(numNodes + 1, 0);
+    ArcID newNumArcs = 0;
+    for (size_t i = 1; i < order.size(); i++) {
+        newID[order[i]] = i;
+        const DSNode& node = getDSNode(order[i]);
+        newNumArcs += node.getNumLeftArcs() + node.getNumRightArcs();
+    }
+
+    NodeID newNumNodes = order.size() - 1;
+
+    // copy the nodes, their coverages and their arcs to dense arrays
+    DSNode* newNodes = new DSNode[newNumNodes+1];
+    NodeCov* newCovs = new NodeCov[newNumNodes+1];
+    Arc* newArcs = new Arc[newNumArcs+2];
+
+    ArcID arcPos = 1;
+    for (NodeID id = 1; id <= newNumNodes; id++) {
+        const DSNode& node = nodes[order[id]];
+        const NodeCov& cov = nodeCovs[order[id]];
+
+        DSNode& newNode = newNodes[id];
+        newNode.setNumLeftArcs(node.getNumLeftArcs());
+        newNode.setNumRightArcs(node.getNumRightArcs());
+
+        newNode.setFirstLeftArcID(arcPos);
+        for (int i = 0; i < node.getNumLeftArcs(); i++, arcPos++) {
+            const Arc& arc = arcs[node.getFirstLeftArcID() + i];
+            newArcs[arcPos] = arc;
+            NodeID target = newID[abs(arc.getNodeID())];
+            assert(target != 0);
+            newArcs[arcPos].setNodeID(arc.getNodeID() > 0 ? target : -target);
+        }
+
+        newNode.setFirstRightArcID(arcPos);
+        for (int i = 0; i < node.getNumRightArcs(); i++, arcPos++) {
+            const Arc& arc = arcs[node.getFirstRightArcID() + i];
+            newArcs[arcPos] = arc;
+            NodeID target = newID[abs(arc.getNodeID())];
+            assert(target != 0);
+            newArcs[arcPos].setNodeID(arc.getNodeID() > 0 ? target : -target);
+        }
+
+        newCovs[id].readStartCov = cov.readStartCov.load();
+        newCovs[id].kmerCov = cov.kmerCov.load();
+        newCovs[id].expMult = cov.expMult;
+    }
+
+    arena.compact(order);
+
+    delete [] nodes;
+    delete [] nodeCovs;
+    delete [] arcs;
+    nodes = newNodes;
+    nodeCovs = newCovs;
+    arcs = newArcs;
+    setStaticPointers();
+
+    // keep track of the original node identifiers
+    vector<NodeID> newOrigNodeID(newNumNodes + 1, 0);
+    for (NodeID id = 1; id <= newNumNodes; id++)
+        newOrigNodeID[id] = getOriginalNodeID(order[id]);
+    origNodeID.swap(newOrigNodeID);
+
+    // renumber the per-node bookkeeping
+    map<NodeID, pair_k> newExpMult;
+    for (auto it : nodesExpMult)
+        if (it.first <= numNodes && newID[it.first] != 0)
+            newExpMult.insert(make_pair(newID[it.first], it.second));
+    nodesExpMult.swap(newExpMult);
+
+#ifdef DEBUG
+    if (!trueMult.empty()) {
+        vector<int> newTrueMult(newNumNodes + 1, 0);
+        for (NodeID id = 1; id <= newNumNodes; id++)
+            newTrueMult[id] = trueMult[order[id]];
+        trueMult.swap(newTrueMult);
+    }
+#endif
+
+    numNodes = newNumNodes;
+    numArcs = newNumArcs;
+
+    // the node identifiers in the change log are no longer valid
+    changeLog.clear();
+    changeLogEpoch++;
+}
+
+void DBGraph::freeNodes()
+{
     delete [] nodes;
+    delete [] nodeCovs;
+    arena.clear();
+
+    nodes = NULL;
+    nodeCovs = NULL;
 }
 
 bool DBGraph::getLeftUniqueSSNode(const SSNode &node, SSNode &leftNode) const
@@ -508,8 +785,11 @@ void DBGraph::createFromFile(const string& nodeFilename,
     if (!nodeFile)
         throw ios_base::failure("Can't open " + nodeFilename);
 
-    nodes = new DSNode[numNodes+1];
-    SSNode::setNodePointer(nodes);
+    // the file size bounds the total sequence length
+    nodeFile.seekg(0, ios::end);
+    allocateNodes(nodeFile.tellg());
+    nodeFile.seekg(0, ios::beg);
+
     for (NodeID id = 1; id <= numNodes; id++) {
         // read the node info
         nodeFile >> dS >> dI >> length >> expMult >> readStartCov >> descriptor;
@@ -651,6 +931,36 @@ void DBGraph::convertNodesToString(const deque<SSNode> &nodeSeq,
     assert(size == output.size());
 }
 
+size_t DBGraph::getPathLength(const vector<NodeID> &path) const
+{
+    size_t length = 0;
+    for (size_t i = 0; i < path.size(); i++)
+        length += arena.getLength(abs(path[i]));
+
+    return length - (path.size() - 1) * (Kmer::getK() - 1);
+}
+
+void DBGraph::writePathSequence(const vector<NodeID> &path, size_t offset)
+{
+    // the positive strand of the destination node spells the path if the
+    // first node is positive, else it spells the reverse complement path
+    vector<NodeID> dsPath(path);
+    if (path.front() < 0) {
+        reverse(dsPath.begin(), dsPath.end());
+        for (size_t i = 0; i < dsPath.size(); i++)
+            dsPath[i] = -dsPath[i];
+    }
+
+    const size_t overlap = Kmer::getK() - 1;
+    for (size_t i = 0, pos = 0; i < dsPath.size(); i++) {
+        NodeID id = dsPath[i];
+        size_t skip = (i == 0) ? 0 : overlap;
+        size_t len = arena.getLength(abs(id)) - skip;
+        arena.copy(offset, pos, abs(id), (id > 0) ? skip : 0, len, id < 0);
+        pos += len;
+    }
+}
+
 void DBGraph::convertNodesToString(const vector<NodeID> &nodeSeq,
                                    int startPos,
                                    int stopPos,
@@ -695,7 +1005,7 @@ void DBGraph::writeGraph(const std::string& nodeFilename,
 
                 numExtractedNodes++;
 
-                nodeFile << ">NODE" << "\t" << id << "\t"
+                nodeFile << ">NODE" << "\t" << getOriginalNodeID(id) << "\t"
                          << node.getLength() << "\t" << node.getKmerCov()
                          << "\t" << node.getReadStartCov() << "\n"
                          << node.getSequence() << "\n";
@@ -783,8 +1093,11 @@ void DBGraph::loadGraphBin(const std::string& nodeFilename,
         if (!nodeFile)
                 throw ios_base::failure("Can't open " + nodeFilename);
 
-        nodes = new DSNode[numNodes+1];
-        SSNode::setNodePointer(nodes);
+        // four nucleotides per byte in the node file
+        nodeFile.seekg(0, ios::end);
+        allocateNodes(4 * (size_t)nodeFile.tellg());
+        nodeFile.seekg(0, ios::beg);
+
         for (NodeID id = 1; id <= numNodes; id++) {
                 // read the node info
 
@@ -806,21 +1119,90 @@ void DBGraph::loadGraphBin(const std::string& nodeFilename,
         arcFile.close();
 }
 
+void DBGraph::addNodeStats(NodeID nodeID)
+{
+    if (!nodeStatsValid)
+        return;
+
+    const DSNode& node = getDSNode(abs(nodeID));
+    LengthBin& bin = nodeStats[node.getMarginalLength()];
+    bin.count++;
+    bin.kmerCov += node.getKmerCov();
+    bin.kmerCovSq += (uint64_t)node.getKmerCov() * node.getKmerCov();
+    bin.readStartCov += node.getReadStartCov();
+}
+
+void DBGraph::removeNodeStats(NodeID nodeID)
+{
+    if (!nodeStatsValid)
+        return;
+
+    const DSNode& node = getDSNode(abs(nodeID));
+    map<size_t, LengthBin>::iterator it = nodeStats.find(node.getMarginalLength());
+    assert(it != nodeStats.end());
+
+    LengthBin& bin = it->second;
+    bin.count--;
+    bin.kmerCov -= node.getKmerCov();
+    bin.kmerCovSq -= (uint64_t)node.getKmerCov() * node.getKmerCov();
+    bin.readStartCov -= node.getReadStartCov();
+    if (bin.count == 0)
+        nodeStats.erase(it);
+}
+
+const map<size_t, DBGraph::LengthBin>& DBGraph::getNodeStats()
+{
+    if (nodeStatsValid)
+        return nodeStats;
+
+    // every thread bins its own share of the nodes, the bins are merged after
+    vector<map<size_t, LengthBin> > threadStats(settings.getNumThreads());
+    parallelFor(1, numNodes + 1, [&](size_t threadID, size_t id) {
+        const DSNode& node = getDSNode(id);
+        if (!node.isValid())
+            return;
+        LengthBin& bin = threadStats[threadID][node.getMarginalLength()];
+        bin.count++;
+        bin.kmerCov += node.getKmerCov();
+        bin.kmerCovSq += (uint64_t)node.getKmerCov() * node.getKmerCov();
+        bin.readStartCov += node.getReadStartCov();
+    });
+
+    nodeStats.clear();
+    for (size_t i = 0; i < threadStats.size(); i++) {
+        for (auto it : threadStats[i]) {
+            LengthBin& bin = nodeStats[it.first];
+            bin.count += it.second.count;
+            bin.kmerCov += it.second.kmerCov;
+            bin.kmerCovSq += it.second.kmerCovSq;
+            bin.readStartCov += it.second.readStartCov;
+        }
+    }
+
+    nodeStatsValid = true;
+    return nodeStats;
+}
+
 size_t DBGraph::updateGraphSize()
 {
-    vector<size_t> nodeLengths;
+    const map<size_t, LengthBin>& stats = getNodeStats();
+
+    // the length of a node equals its marginal length + k - 1
+    sizeOfGraph = 0;
+    size_t numExtractedNodes = 0, totalLength = 0;
+    for (auto it : stats) {
+        numExtractedNodes += it.second.count;
+        sizeOfGraph += (it.first + Kmer::getK()) * it.second.count;
+        totalLength += (it.first + Kmer::getK() - 1) * it.second.count;
+    }
 
-    sizeOfGraph=0;
-    size_t numExtractedNodes = 0, numExtractedArcs = 0;
+#ifdef DEBUG
+    size_t numExtractedArcs = 0;
     for (NodeID id = 1; id <= numNodes; id++) {
         SSNode node = getSSNode(id);
-
         if (!node.isValid())
             continue;
 
-        numExtractedNodes++;
-        //check later for adding kmerSize
-        sizeOfGraph=sizeOfGraph +node.getMarginalLength()+ Kmer::getK();
         KmerOverlap ol;
         for (ArcIt it = node.leftBegin(); it != node.leftEnd(); it++) {
             char c = getSSNode(it->getNodeID()).getRightKmer().peekNucleotideLeft();
@@ -832,38 +1214,40 @@ size_t DBGraph::updateGraphSize()
             ol.markRightOverlap(c);
         }
         numExtractedArcs += ol.getNumLeftOverlap() + ol.getNumRightOverlap();
-
-        nodeLengths.push_back(node.getLength());
     }
 
-
-#ifdef DEBUG
     cout<<"size of graph: "<<sizeOfGraph<<endl;
     cout<<"number of valid Node: "<<numExtractedNodes<<endl;
     cout << "Extracted " << numExtractedNodes << " nodes and "
          << numExtractedArcs << " arcs." << endl;
 #endif
-    sort(nodeLengths.begin(), nodeLengths.end());
-
-    size_t totalLength = 0;
-    for (size_t i = 0; i < nodeLengths.size(); i++)
-        totalLength += nodeLengths[i];
-    size_t currLength = 0;
-    size_t n50;
-    for (size_t i = 0; i < nodeLengths.size(); i++) {
-        currLength += nodeLengths[i];
-        if (currLength >= 0.5*totalLength) {
+
+    // walk the length histogram in increasing order
+    size_t currLength = 0, currNodes = 0;
+    size_t n50 = 0;
+    for (auto it : stats) {
+        size_t length = it.first + Kmer::getK() - 1;
+        size_t count = it.second.count;
+        if (currLength + length * count < 0.5*totalLength) {
+            currLength += length * count;
+            currNodes += count;
+            continue;
+        }
+
 #ifdef DEBUG
-            cout << endl << "N50 is " << nodeLengths[i] << " (total length: " << totalLength << ")" << endl;
-            cout << "This was found at node " << i << "/" << numNodes << endl;
+        // the N50 length is reached within this bin
+        for (; currLength + length < 0.5*totalLength; currLength += length)
+            currNodes++;
+        cout << endl << "N50 is " << length << " (total length: " << totalLength << ")" << endl;
+        cout << "This was found at node " << currNodes << "/" << numNodes << endl;
 #endif
-            n50= nodeLengths[i];
-            this->n50=n50;
-            break;
-        }
+        n50 = length;
+        this->n50 = n50;
+        break;
     }
 #ifdef DEBUG
-    cout << "The largest node contains " << nodeLengths.back() << " basepairs." << endl;
+    if (!stats.empty())
+        cout << "The largest node contains " << stats.rbegin()->first + Kmer::getK() - 1 << " basepairs." << endl;
     cout <<"N50:"<<n50<<endl;
 #endif
     return sizeOfGraph;
@@ -24,7 +24,12 @@
 #include "global.h"
 #include "ssnode.h"
 #include "dsnode.h"
+#include "settings.h"
+#include "scratchmap.h"
 #include <deque>
+#include <atomic>
+#include <algorithm>
+#include <functional>
 #include "essaMEM-master/sparseSA.hpp"
 
 
@@ -145,6 +150,66 @@ private:
     void convertNodesToString(const std::deque<SSNode> &nodeSeq,
                               std::string &output);
 
+    /**
+     * Get the length of the sequence spelled by a path of overlapping nodes
+     * @param path Path of overlapping nodes (signed node identifiers)
+     * @return The number of nucleotides
+     */
+    size_t getPathLength(const std::vector<NodeID> &path) const;
+
+    /**
+     * Write the sequence spelled by a path of overlapping nodes to allocated
+     * arena space, oriented as the positive strand of the first node. Paths
+     * can be written concurrently to different allocated spaces.
+     * @param path Path of overlapping nodes (signed node identifiers)
+     * @param offset Word offset of the allocated space
+     */
+    void writePathSequence(const std::vector<NodeID> &path, size_t offset);
+
+    /**
+     * Check if a node can be merged with its right neighbour, i.e. the node
+     * has a single right arc to a node with a single left arc
+     * @param nodeID Signed node identifier
+     * @param force Merge regardless of the node coverage
+     * @param rightID Signed identifier of the right neighbour (output)
+     * @return True if both nodes can be merged
+     */
+    bool getMergeableRight(NodeID nodeID, bool force, NodeID &rightID) const;
+
+    /**
+     * Call func(threadID, i) for all i in [begin, end) using all threads.
+     * Indices are handed out in chunks, so the order of the calls is
+     * undefined.
+     * @param begin First index
+     * @param end Past the last index
+     * @param func Function object that takes a thread ID and an index
+     */
+    template<class Func>
+    void parallelFor(size_t begin, size_t end, Func func) const {
+        const size_t chunkSize = 1024;
+        std::atomic<size_t> next(begin);
+
+        auto worker = [&](size_t threadID) {
+            for (size_t b = next.fetch_add(chunkSize); b < end;
+                 b = next.fetch_add(chunkSize))
+                for (size_t i = b; i < std::min(b + chunkSize, end); i++)
+                    func(threadID, i);
+        };
+
+        size_t numThreads = settings.getNumThreads();
+        if ((numThreads == 1) || (end <= begin + chunkSize)) {
+            worker(0);
+            return;
+        }
+
+        std::vector<std::thread> workerThreads(numThreads);
+        for (size_t i = 0; i < workerThreads.size(); i++)
+            workerThreads[i] = std::thread(worker, i);
+
+        std::for_each(workerThreads.begin(), workerThreads.end(),
+                      std::mem_fn(&std::thread::join));
+    }
+
     /**
      *
      *
@@ -164,18 +229,141 @@ private:
 
     void markPairedArcs(const std::vector<NodeID>& seq);
 
+    /**
+     * Allocate the node arrays (topology, sequence and coverage arrays)
+     * for numNodes nodes and set the static node pointers
+     * @param expNumNucleotides Expected total length of the node sequences
+     */
+    void allocateNodes(size_t expNumNucleotides);
+
+    /**
+     * Free the node arrays
+     */
+    void freeNodes();
+
+    /**
+     * Incremental state of a graph purification pass: the position in the
+     * change log up to which the pass has seen all changes and the
+     * parameters it last ran with
+     */
+    struct PassState {
+        size_t epoch;                   // change log epoch (0 = never ran)
+        size_t logPos;                  // position in the change log
+        std::vector<double> params;     // parameters of the last run
+
+        PassState() : epoch(0), logPos(0) {}
+    };
+
+    /**
+     * Record that a node was changed by a purification pass
+     * @param nodeID Node identifier (either strand)
+     */
+    void logChange(NodeID nodeID) {
+        changeLog.push_back(abs(nodeID));
+    }
+
+    /**
+     * Record that a node and its neighbours were changed
+     * @param nodeID Node identifier (either strand)
+     */
+    void logNeighbourhood(NodeID nodeID);
+
+    /**
+     * Get the nodes that changed since the previous run of a pass. A full
+     * sweep is required when the pass never ran, when its parameters
+     * changed or when too many nodes changed.
+     * @param state Incremental state of the pass (updated)
+     * @param params Current parameters of the pass
+     * @param worklist Sorted, unique changed nodes (output)
+     * @return True if the pass may restrict itself to the worklist
+     */
+    bool getWorklist(PassState& state, const std::vector<double>& params,
+                     std::vector<NodeID>& worklist);
+
+    /**
+     * Collect the roots of bubble searches that can reach a node, i.e. the
+     * node itself and the nodes within a given distance to its left
+     * @param nodeID Signed node identifier
+     * @param depth Maximum search depth (in nucleotides)
+     * @param dist Scratch map with distances (cleared on return)
+     * @param roots Roots are appended to this vector (may contain duplicates)
+     */
+    void getBubbleRoots(NodeID nodeID, size_t depth,
+                        ScratchMap<NodeID, size_t>& dist,
+                        std::vector<NodeID>& roots) const;
+
+    /**
+     * Get an order of the valid nodes in which neighbours are close: a
+     * breadth-first search from seeds in order of decreasing coverage
+     * @param order Node identifiers, order[0] = 0 (output)
+     */
+    void getLocalityOrder(std::vector<size_t>& order) const;
+
+    /**
+     * Move nodes, coverages, sequences and arcs to new arrays in a given
+     * order, dropping all other nodes. The original identifiers, the
+     * expected multiplicities and (DEBUG) the true multiplicities follow.
+     * @param order Old node identifiers, order[i] gets identifier i
+     */
+    void renumberNodes(const std::vector<size_t>& order);
+
+    /**
+     * Aggregated statistics of the valid nodes with a given marginal length
+     */
+    struct LengthBin {
+        size_t count;           // number of nodes
+        uint64_t kmerCov;       // sum of the kmer coverages
+        uint64_t kmerCovSq;     // sum of the squared kmer coverages
+        uint64_t readStartCov;  // sum of the read start coverages
+
+        LengthBin() : count(0), kmerCov(0), kmerCovSq(0), readStartCov(0) {}
+    };
+
+    /**
+     * Add a valid node to the node statistics (if they are maintained)
+     * @param nodeID Node identifier (either strand)
+     */
+    void addNodeStats(NodeID nodeID);
+
+    /**
+     * Remove a valid node from the node statistics (if they are maintained)
+     * @param nodeID Node identifier (either strand)
+     */
+    void removeNodeStats(NodeID nodeID);
+
+    /**
+     * Get the node statistics, binned by marginal length. They are
+     * recomputed from scratch (in parallel) only when they were invalidated,
+     * afterwards node removals and merges keep them up-to-date.
+     * @return Length bins, sorted by marginal length
+     */
+    const std::map<size_t, LengthBin>& getNodeStats();
+
     // ====================================================================
     // VARIABLES
     // ====================================================================
 
     const Settings &settings;     // settings object
 
-    DSNode *nodes;          // graph nodes
+    DSNode *nodes;          // graph nodes (topology only)
+    SequenceArena arena;    // node sequences (same indexing as nodes)
+    NodeCov *nodeCovs;      // node coverages (same indexing as nodes)
     Arc *arcs;              // graph arcs
 
     NodeID numNodes;        // number of nodes
     NodeID numArcs;         // number of arcs
 
+    std::vector<NodeID> changeLog;  // nodes changed by purification passes
+    size_t changeLogEpoch;          // incremented when the log is reset
+    PassState clipTipsState;        // incremental state of clipTips
+    NodeID clipTipsFirstSafeID;     // idem, first isolated node or joined tip
+    PassState mergeState[2];        // idem, mergeSingleNodes (force = 0/1)
+    std::map<size_t, PassState> bubbleState;    // idem, bubbleDetection
+
+    std::map<size_t, LengthBin> nodeStats;      // node statistics per length
+    bool nodeStatsValid;                        // nodeStats is up-to-date
+    std::vector<NodeID> origNodeID;     // original ID of compacted nodes
+
     MapType mapType;
 
     double coverage;//=100;
@@ -222,13 +410,13 @@ public:
     bool bubbleDetection(int round);
     vector<pair<SSNode, SSNode> >  ExtractBubbles(SSNode rootNode,std::set<NodeID>& visitedNodes , std::set<Arc *>&visitedArc);
     bool removeBubble(SSNode &prevFirstNode ,SSNode& extendFirstNode,size_t &TP,size_t &TN,size_t &FP,size_t &FN,size_t & numOfDel);
-    void extractPath(NodeID currID, const vector<NodeID>& prevNode) const;
-    vector<NodeID> getPath(NodeID currID, const vector<NodeID>& prevNode) const;
+    void extractPath(NodeID currID, const ScratchMap<NodeID, NodeID>& prevNode) const;
+    vector<NodeID> getPath(NodeID currID, const ScratchMap<NodeID, NodeID>& prevNode) const;
     bool removeNotSingleBubbles(  SSNode &prevFirstNode ,SSNode& extendFirstNode, size_t &TP,size_t &TN,size_t &FP,size_t &FN,size_t & numOfDel);
     bool whichOneIsbubble(SSNode rootNode,bool &first, SSNode &prevFirstNode ,SSNode& extendFirstNode, bool onlySingle, double threshold);
     bool whichOneIsbubble(SSNode rootNode,bool &first, SSNode &prevFirstNode ,SSNode& extendFirstNode, bool onlySingle);
     bool nodeIsBubble(SSNode node, SSNode currNode);
-    vector<pair<vector<NodeID>, vector<NodeID>> >  searchForParallelNodes(SSNode node,vector<NodeID> &visited, vector<NodeID> &prevNode,vector<NodeID> &nodeColor, int depth);
+    vector<pair<vector<NodeID>, vector<NodeID>> >  searchForParallelNodes(SSNode node, ScratchMap<NodeID, NodeID> &prevNode, ScratchMap<NodeID, NodeID> &nodeColor, int depth);
     vector<pair<vector<NodeID>, vector<NodeID>> > searchForParallelNodes(SSNode node, int depth);
     bool hasLowCovNode(SSNode root);
 
@@ -239,6 +427,39 @@ public:
  *
  */
     bool removeNode(SSNode &rootNode);
+
+    /**
+     * Remove a set of nodes together with all arcs that connect to them.
+     * Every thread only modifies the arcs of its own nodes, so the removal
+     * runs in parallel and does not depend on the order of the nodes.
+     * @param nodeIDs Lists of signed node identifiers (e.g. one per thread)
+     * @return The number of removed nodes
+     */
+    size_t removeNodes(const std::vector<std::vector<NodeID> >& nodeIDs);
+
+    /**
+     * Move the valid nodes and their arcs to new, dense arrays when more
+     * than half of the nodes were removed. The nodes keep their relative
+     * order, their original identifiers are retained.
+     * @return True if the graph was compacted
+     */
+    bool compactGraph();
+
+    /**
+     * Renumber the valid nodes in traversal order (see getLocalityOrder)
+     * such that neighbouring nodes are close together in memory
+     */
+    void reorderNodes();
+
+    /**
+     * Get the identifier a node had before the graph was compacted
+     * @param nodeID Current node identifier (> 0)
+     * @return The original node identifier
+     */
+    NodeID getOriginalNodeID(NodeID nodeID) const {
+        return origNodeID.empty() ? nodeID : origNodeID[nodeID];
+    }
+
     bool mergeSingleNodes(bool force);
     void extractStatistic(int round);
     bool checkNodeIsReliable(SSNode node);
@@ -253,6 +474,21 @@ public:
 
     // void filterCoverage();
 
+    /**
+     * Turn this graph into a copy of the topology and coverage of another
+     * graph, without the node sequences (only their lengths). This is
+     * sufficient for coverage filtering, tip clipping, merging and the
+     * coverage statistics. The static node and arc pointers refer to this
+     * graph afterwards.
+     * @param source Graph to copy
+     */
+    void cloneTopology(const DBGraph& source);
+
+    /**
+     * Let the static node and arc pointers refer to this graph
+     */
+    void setStaticPointers();
+
     /**
      * Default constructor
      */
@@ -381,9 +617,8 @@ public:
      * Clear all nodes and arcs in this graph
      */
     void clear() {
-        delete [] nodes;
+        freeNodes();
         delete [] arcs;
-        nodes = NULL;
         arcs = NULL;
         numNodes = numArcs = 0;
     }
@@ -169,13 +169,12 @@ void KmerNodeTable::populateTable(const DSNode* nodes)
                 const DSNode &node = nodes[id];
                 if (!node.isValid())
                         continue;
-                const TString& tStr = node.getTSequence();
-                Kmer kmer(tStr);
+                Kmer kmer = node.getLeftKmer();
                 PositionID pos = 0;
                 insert(kmer, id, pos++, node);
 
-                for (size_t i = Kmer::getK(); i < tStr.getLength(); i++) {
-                        kmer.pushNucleotideRight(tStr[i]);
+                for (size_t i = Kmer::getK(); i < node.getLength(); i++) {
+                        kmer.pushNucleotideRight(node.getNucleotide(i));
                         insert(kmer, id, pos++, node);
                 }
         }
@@ -263,14 +263,17 @@ double LibraryContainer::getAvgReadLength() const
         return (double)sumReadLength/(double)sumReads;
 }
 
-bool LibraryContainer::getRecordChunk(vector<ReadRecord>& buffer,
-                                      size_t& blockID, size_t& recordOffset)
+bool LibraryContainer::takeRecordChunk(vector<ReadRecord>& buffer,
+                                       size_t& blockID, size_t& recordOffset,
+                                       bool wait)
 {
         // clear the buffer
         buffer.clear();
 
         // A) wait until work becomes available
         std::unique_lock<std::mutex> workLock(workMutex);
+        if (!wait && workBlocks.find(currWorkBlockID) == workBlocks.end())
+                return true;
         workReady.wait(workLock, [this]{return workBlocks.find(currWorkBlockID) !=
                                                workBlocks.end(); });
 
@@ -284,6 +287,7 @@ bool LibraryContainer::getRecordChunk(vector<ReadRecord>& buffer,
                 // send a termination message to the output thread
                 std::unique_lock<std::mutex> outputLock(outputMutex);
                 outputBlocks[currWorkBlockID] = NULL;
+                outputReady.notify_one();
                 outputLock.unlock();
 
                 // and get out
@@ -339,6 +343,7 @@ bool LibraryContainer::getReadChunk(vector<string>& buffer,
                 // send a termination message to the output thread
                 std::unique_lock<std::mutex> outputLock(outputMutex);
                 outputBlocks[currWorkBlockID] = NULL;
+                outputReady.notify_one();
                 outputLock.unlock();
 
                 // and get out
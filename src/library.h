@@ -310,6 +310,17 @@ private:
          */
         void outputThreadEntry();
 
+        /**
+         * Get next record chunk from the input
+         * @param buffer Buffer in which to store the records (output)
+         * @param blockID Block identifier (output)
+         * @param recordOffset Record offset within the block (output)
+         * @param wait Wait for work, otherwise return an empty buffer
+         * @return False if no more reads are available, true otherwise
+         */
+        bool takeRecordChunk(std::vector<ReadRecord>& buffer,
+                             size_t& blockID, size_t& recordOffset, bool wait);
+
 public:
         /**
          * Add a read library to the container
@@ -361,7 +372,23 @@ public:
          * @return False if no more reads are available, true otherwise
          */
         bool getRecordChunk(std::vector<ReadRecord>& buffer,
-                            size_t& blockID, size_t& recordOffset);
+                            size_t& blockID, size_t& recordOffset) {
+                return takeRecordChunk(buffer, blockID, recordOffset, true);
+        }
+
+        /**
+         * Get next record chunk from the input if it is available right
+         * away, i.e. without waiting for the input thread
+         * @param buffer Buffer in which to store the records (output),
+         * empty if no work is available at this point
+         * @param blockID Block identifier (output)
+         * @param recordOffset Record offset within the block (output)
+         * @return False if no more reads are available, true otherwise
+         */
+        bool tryGetRecordChunk(std::vector<ReadRecord>& buffer,
+                               size_t& blockID, size_t& recordOffset) {
+                return takeRecordChunk(buffer, blockID, recordOffset, false);
+        }
 
         /**
          * Get next read chunk from the input
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "minimizerindex.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+// ============================================================================
+// MINIMIZER INDEX CLASS
+// ============================================================================
+
+MinimizerIndex::MinimizerIndex(size_t k_, size_t w_, size_t maxOccurrences_) :
+        k(k_), w(w_), maxOccurrences(maxOccurrences_), bucketShift(0)
+{
+        assert(k > 0 && k <= 31);
+        assert(w > 0);
+}
+
+void MinimizerIndex::getMinimizers(const string& seq,
+                                   vector<Minimizer>& minimizers) const
+{
+        minimizers.clear();
+        if (seq.size() < k)
+                return;
+
+        // hash values of all k-mers, invalid k-mers are never selected
+        const uint64_t invalidKey = numeric_limits<uint64_t>::max();
+        const uint64_t mask = (uint64_t(1) << (2 * k)) - 1;
+        size_t numKmers = seq.size() + 1 - k;
+        vector<uint64_t> keys(numKmers, invalidKey);
+
+        uint64_t kmer = 0;
+        size_t numValid = 0;            // number of consecutive ACGT chars
+        for (size_t i = 0; i < seq.size(); i++) {
+                uint64_t n;
+                switch (seq[i]) {
+                        case 'A': n = 0; break;
+                        case 'C': n = 1; break;
+                        case 'G': n = 2; break;
+                        case 'T': n = 3; break;
+                        default: numValid = 0; continue;
+                }
+
+                kmer = ((kmer << 2) | n) & mask;
+                if (++numValid >= k)
+                        keys[i + 1 - k] = hash(kmer, mask);
+        }
+
+        // select the leftmost smallest key in each window of w k-mers
+        size_t windowSize = min(w, numKmers);
+        size_t minPos = numKmers;
+        for (size_t end = 0; end < numKmers; end++) {
+                size_t first = (end + 1 >= windowSize) ? end + 1 - windowSize : 0;
+                if (minPos == numKmers || minPos < first) {
+                        minPos = first;
+                        for (size_t i = first + 1; i <= end; i++)
+                                if (keys[i] < keys[minPos])
+                                        minPos = i;
+                } else if (keys[end] < keys[minPos]) {
+                        minPos = end;
+                }
+
+                if (end + 1 < windowSize || keys[minPos] == invalidKey)
+                        continue;
+
+                if (minimizers.empty() || minimizers.back().pos != minPos)
+                        minimizers.push_back(Minimizer(keys[minPos], minPos));
+        }
+}
+
+void MinimizerIndex::addSequence(NodeID nodeID, const string& seq)
+{
+        vector<Minimizer> minimizers;
+        getMinimizers(seq, minimizers);
+
+        for (auto& it : minimizers)
+                entries.push_back(Entry(it.key, nodeID, it.pos));
+}
+
+void MinimizerIndex::finalize()
+{
+        sort(entries.begin(), entries.end());
+        entries.shrink_to_fit();
+
+        // about four entries per bucket
+        size_t bucketBits = 0;
+        while ((bucketBits < 2 * k) && ((size_t(4) << bucketBits) < entries.size()))
+                bucketBits++;
+        bucketShift = 2 * k - bucketBits;
+
+        size_t numBuckets = size_t(1) << bucketBits;
+        bucket.assign(numBuckets + 1, 0);
+        for (auto& it : entries)
+                bucket[(it.key >> bucketShift) + 1]++;
+        for (size_t i = 0; i < numBuckets; i++)
+                bucket[i + 1] += bucket[i];
+}
+
+void MinimizerIndex::findHits(const string& seq,
+                              vector<MinimizerHit>& hits) const
+{
+        hits.clear();
+        if (entries.empty())
+                return;
+
+        vector<Minimizer> minimizers;
+        getMinimizers(seq, minimizers);
+
+        for (auto& it : minimizers) {
+                size_t b = it.key >> bucketShift;
+                auto first = entries.begin() + bucket[b];
+                auto last = entries.begin() + bucket[b + 1];
+
+                auto range = equal_range(first, last, Entry(it.key, 0, 0));
+
+                // repetitive minimizers are not informative
+                if ((size_t)distance(range.first, range.second) > maxOccurrences)
+                        continue;
+
+                for (auto e = range.first; e != range.second; e++)
+                        hits.push_back(MinimizerHit(e->nodeID, e->pos, it.pos));
+        }
+}
@@ -0,0 +1,181 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef MINIMIZERINDEX_H
+#define MINIMIZERINDEX_H
+
+#include "global.h"
+
+#include <vector>
+#include <string>
+
+// ============================================================================
+// MINIMIZER CLASS
+// ============================================================================
+
+class Minimizer {
+
+public:
+        uint64_t key;           // hash value of the k-mer
+        uint32_t pos;           // position of the k-mer in the sequence
+
+        Minimizer(uint64_t key_, uint32_t pos_) : key(key_), pos(pos_) {}
+};
+
+// ============================================================================
+// MINIMIZER HIT CLASS
+// ============================================================================
+
+class MinimizerHit {
+
+public:
+        NodeID nodeID;          // node identifier (always positive)
+        uint32_t nodePos;       // position of the k-mer in the node
+        uint32_t seqPos;        // position of the k-mer in the query
+
+        MinimizerHit(NodeID nodeID_, uint32_t nodePos_, uint32_t seqPos_) :
+                nodeID(nodeID_), nodePos(nodePos_), seqPos(seqPos_) {}
+
+        bool operator< (const MinimizerHit& rhs) const {
+                if (nodeID != rhs.nodeID)
+                        return nodeID < rhs.nodeID;
+                if (getDiagonal() != rhs.getDiagonal())
+                        return getDiagonal() < rhs.getDiagonal();
+                return seqPos < rhs.seqPos;
+        }
+
+        /**
+         * Get the diagonal of the hit (node position - query position)
+         * @return The diagonal
+         */
+        int64_t getDiagonal() const {
+                return (int64_t)nodePos - (int64_t)seqPos;
+        }
+};
+
+// ============================================================================
+// MINIMIZER INDEX CLASS
+// ============================================================================
+
+/**
+ * Seed index with the (w,k)-minimizers of the (forward) node sequences. The
+ * minimizers are kept in a single array sorted by their hash value, with a
+ * table that maps the top bits of a hash value onto its bucket in that array.
+ */
+class MinimizerIndex {
+
+private:
+        class Entry {
+        public:
+                uint64_t key;   // hash value of the k-mer
+                NodeID nodeID;  // node identifier
+                uint32_t pos;   // position of the k-mer in the node
+
+                Entry(uint64_t key_, NodeID nodeID_, uint32_t pos_) :
+                        key(key_), nodeID(nodeID_), pos(pos_) {}
+
+                bool operator< (const Entry& rhs) const {
+                        return key < rhs.key;
+                }
+        };
+
+        size_t k;                       // k-mer size (at most 31)
+        size_t w;                       // number of k-mers per window
+        size_t maxOccurrences;          // ignore more frequent minimizers
+        std::vector<Entry> entries;     // entries sorted by key
+        std::vector<uint32_t> bucket;   // first entry per bucket (+1 guard)
+        size_t bucketShift;             // key >> bucketShift = bucket ID
+
+        /**
+         * Invertible hash of a 2-bit encoded k-mer, such that low-complexity
+         * k-mers (e.g. AAA...A) are not systematically selected
+         * @param x 2-bit encoded k-mer
+         * @param mask Mask with the lower 2k bits set
+         * @return Hash value in [0, mask]
+         */
+        static uint64_t hash(uint64_t x, uint64_t mask) {
+                x = (~x + (x << 21)) & mask;
+                x = x ^ x >> 24;
+                x = ((x + (x << 3)) + (x << 8)) & mask;
+                x = x ^ x >> 14;
+                x = ((x + (x << 2)) + (x << 4)) & mask;
+                x = x ^ x >> 28;
+                x = (x + (x << 31)) & mask;
+                return x;
+        }
+
+public:
+        /**
+         * Default constructor
+         * @param k_ K-mer size (at most 31)
+         * @param w_ Number of consecutive k-mers in a window
+         * @param maxOccurrences_ Minimizers that occur more often are ignored
+         */
+        MinimizerIndex(size_t k_, size_t w_, size_t maxOccurrences_ = 64);
+
+        /**
+         * Get the (w,k)-minimizers of a sequence. K-mers that contain a
+         * character other than 'A', 'C', 'G' or 'T' are never selected.
+         * @param seq Sequence under consideration
+         * @param minimizers Minimizers in order of position (output)
+         */
+        void getMinimizers(const std::string& seq,
+                           std::vector<Minimizer>& minimizers) const;
+
+        /**
+         * Add the minimizers of a node sequence to the index
+         * @param nodeID Node identifier
+         * @param seq Node sequence
+         */
+        void addSequence(NodeID nodeID, const std::string& seq);
+
+        /**
+         * Sort the entries and create the bucket table, must be called after
+         * the last addSequence() and before findHits()
+         */
+        void finalize();
+
+        /**
+         * Find the node k-mers that share a minimizer with a query sequence
+         * @param seq Query sequence
+         * @param hits Hits in arbitrary order (output)
+         */
+        void findHits(const std::string& seq,
+                      std::vector<MinimizerHit>& hits) const;
+
+        /**
+         * Get the number of minimizers in the index
+         * @return The number of minimizers in the index
+         */
+        size_t getNumEntries() const {
+                return entries.size();
+        }
+
+        /**
+         * Get the k-mer size
+         * @return The k-mer size
+         */
+        size_t getK() const {
+                return k;
+        }
+};
+
+#endif
@@ -0,0 +1,151 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "readcache.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// ============================================================================
+// READ KEY CLASS
+// ============================================================================
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+        return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdull;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ull;
+        k ^= k >> 33;
+        return k;
+}
+
+ReadKey::ReadKey(const string& read)
+{
+        const uint8_t *data = (const uint8_t*)read.data();
+        const size_t len = read.size();
+        const uint64_t c1 = 0x87c37b91114253d5ull;
+        const uint64_t c2 = 0x4cf5ad432745937full;
+
+        h1 = h2 = 0;
+
+        // body: blocks of 16 bytes
+        size_t numBlocks = len / 16;
+        for (size_t i = 0; i < numBlocks; i++) {
+                uint64_t k1, k2;
+                memcpy(&k1, data + 16 * i, 8);
+                memcpy(&k2, data + 16 * i + 8, 8);
+
+                k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+                k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        // tail: the remaining 0 to 15 bytes
+        const uint8_t *tail = data + 16 * numBlocks;
+        size_t rem = len % 16;
+
+        uint64_t k1 = 0, k2 = 0;
+        for (size_t i = rem; i > 8; i--)
+                k2 ^= uint64_t(tail[i-1]) << (8 * (i-9));
+        if (rem > 8) {
+                k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        }
+
+        for (size_t i = min<size_t>(rem, 8); i > 0; i--)
+                k1 ^= uint64_t(tail[i-1]) << (8 * (i-1));
+        if (rem > 0) {
+                k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+
+        // finalization
+        h1 ^= len; h2 ^= len;
+        h1 += h2; h2 += h1;
+        h1 = fmix64(h1); h2 = fmix64(h2);
+        h1 += h2; h2 += h1;
+}
+
+// ============================================================================
+// READ CACHE CLASS
+// ============================================================================
+
+ReadCache::ReadCache(size_t capacity, size_t numShards) :
+        shardCapacity(max<size_t>(1, (capacity + numShards - 1) / numShards)),
+        shards(max<size_t>(1, numShards)) {}
+
+bool ReadCache::find(const ReadKey& key, CorrectedRead& value)
+{
+        Shard& shard = getShard(key);
+        lock_guard<mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+                return false;
+
+        Slot& slot = shard.slots[it->second];
+        slot.referenced = true;
+        value = slot.value;
+        return true;
+}
+
+void ReadCache::insert(const ReadKey& key, const CorrectedRead& value)
+{
+        Shard& shard = getShard(key);
+        lock_guard<mutex> lock(shard.mutex);
+
+        if (shard.index.find(key) != shard.index.end())
+                return;
+
+        // fill the shard before evicting anything
+        if (shard.slots.size() < shardCapacity) {
+                shard.index[key] = shard.slots.size();
+                shard.slots.push_back(Slot());
+                shard.slots.back().key = key;
+                shard.slots.back().value = value;
+                shard.slots.back().referenced = false;
+                return;
+        }
+
+        // CLOCK: evict the first slot that was not referenced since the
+        // previous pass of the hand
+        while (shard.slots[shard.hand].referenced) {
+                shard.slots[shard.hand].referenced = false;
+                shard.hand = (shard.hand + 1) % shardCapacity;
+        }
+
+        Slot& victim = shard.slots[shard.hand];
+        shard.index.erase(victim.key);
+        shard.index[key] = shard.hand;
+        victim.key = key;
+        victim.value = value;
+        victim.referenced = false;
+
+        shard.hand = (shard.hand + 1) % shardCapacity;
+}
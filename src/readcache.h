@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef READCACHE_H
+#define READCACHE_H
+
+#include "global.h"
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+// ============================================================================
+// READ KEY CLASS
+// ============================================================================
+
+/**
+ * 128-bit hash of a read sequence (MurmurHash3 x64_128)
+ */
+class ReadKey {
+
+public:
+        uint64_t h1;            // lower 64 bits
+        uint64_t h2;            // upper 64 bits
+
+        ReadKey() : h1(0), h2(0) {}
+
+        /**
+         * Compute the key of a read
+         * @param read Read sequence
+         */
+        explicit ReadKey(const std::string& read);
+
+        bool operator==(const ReadKey& rhs) const {
+                return (h1 == rhs.h1) && (h2 == rhs.h2);
+        }
+};
+
+class ReadKeyHash {
+
+public:
+        size_t operator()(const ReadKey& key) const {
+                return key.h1;
+        }
+};
+
+// ============================================================================
+// CORRECTED READ CLASS
+// ============================================================================
+
+class CorrectedRead {
+
+public:
+        std::string read;               // corrected read (if corrected)
+        bool corrected;                 // true if the read was corrected
+        bool corrByMEM;                 // true if MEM procedure was used
+        size_t numSubstitutions;        // number of substitutions
+
+        CorrectedRead() : corrected(false), corrByMEM(false),
+                numSubstitutions(0) {}
+};
+
+// ============================================================================
+// READ CACHE CLASS
+// ============================================================================
+
+/**
+ * Concurrent cache with the corrections of reads, such that duplicate reads
+ * need to be corrected only once. The cache is split into shards with their
+ * own mutex. Each shard holds a fixed number of entries that are evicted
+ * using the CLOCK algorithm (second chance).
+ */
+class ReadCache {
+
+private:
+        class Slot {
+        public:
+                ReadKey key;                    // key of the read
+                CorrectedRead value;            // its correction
+                bool referenced;                // CLOCK reference bit
+        };
+
+        class Shard {
+        public:
+                std::mutex mutex;               // protects the shard
+                std::unordered_map<ReadKey, size_t, ReadKeyHash> index;
+                std::vector<Slot> slots;        // at most shardCapacity slots
+                size_t hand;                    // CLOCK hand
+
+                Shard() : hand(0) {}
+        };
+
+        size_t shardCapacity;                   // number of slots per shard
+        std::vector<Shard> shards;              // cache shards
+
+        /**
+         * Get the shard that holds a key
+         * @param key Key under consideration
+         * @return Reference to the shard
+         */
+        Shard& getShard(const ReadKey& key) {
+                return shards[key.h2 % shards.size()];
+        }
+
+public:
+        /**
+         * Default constructor
+         * @param capacity Maximum number of reads in the cache
+         * @param numShards Number of shards
+         */
+        ReadCache(size_t capacity, size_t numShards = 64);
+
+        /**
+         * Look up a read (thread-safe)
+         * @param key Key of the read
+         * @param value Correction of the read (output)
+         * @return True if the read was found
+         */
+        bool find(const ReadKey& key, CorrectedRead& value);
+
+        /**
+         * Insert a read, possibly evicting another one (thread-safe)
+         * @param key Key of the read
+         * @param value Correction of the read
+         */
+        void insert(const ReadKey& key, const CorrectedRead& value);
+};
+
+#endif
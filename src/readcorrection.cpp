@@ -21,6 +21,9 @@
 #include <thread>
 #include <string>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
 
 #include "library.h"
 #include "readcorrection.h"
@@ -39,6 +42,13 @@ void AlignmentMetrics::addMetrics(const AlignmentMetrics& rhs)
         numCorrReads += rhs.numCorrReads;
         numCorrByMEM += rhs.numCorrByMEM;
         numSubstitutions += rhs.numSubstitutions;
+        numSolidReads += rhs.numSolidReads;
+        numOverBudget += rhs.numOverBudget;
+        numRetried += rhs.numRetried;
+        numCacheLookups += rhs.numCacheLookups;
+        numCacheHits += rhs.numCacheHits;
+        for (size_t i = 0; i < numWorkBins; i++)
+                workHistogram[i] += rhs.workHistogram[i];
 }
 
 void AlignmentMetrics::printStatistics() const
@@ -51,6 +61,9 @@ void AlignmentMetrics::printStatistics() const
         cout << "\tNumber of corrected reads: " << numCorrReads
              << fixed << setprecision(2) << " ("
              << Util::toPercentage(numCorrReads, numReads) << "%)" << endl;
+        cout << "\tNumber of reads found as-is in the graph: " << numSolidReads
+             << fixed << setprecision(2) << " ("
+             << Util::toPercentage(numSolidReads, numReads) << "%)" << endl;
         cout << "\tNumber of reads corrected by kmer seeds: " << numCorrByKmer
              << fixed << setprecision(2) << " ("
              << Util::toPercentage(numCorrByKmer, numReads) << "%)" << endl;
@@ -63,6 +76,32 @@ void AlignmentMetrics::printStatistics() const
         cout << "\tNumber of uncorrected reads: " << numUncorrected
              << fixed << setprecision(2) << " ("
              << Util::toPercentage(numUncorrected, numReads) << "%)" << endl;
+        cout << "\tNumber of reads that exceeded the work budget: " << numOverBudget
+             << fixed << setprecision(2) << " ("
+             << Util::toPercentage(numOverBudget, numReads) << "%)" << endl;
+        cout << "\tNumber of reads retried with the retry budget: " << numRetried
+             << fixed << setprecision(2) << " ("
+             << Util::toPercentage(numRetried, numReads) << "%)" << endl;
+
+        if (numCacheLookups > 0)
+                cout << "\tNumber of reads taken from the duplicate read cache: " << numCacheHits
+                     << fixed << setprecision(2) << " (hit rate of "
+                     << Util::toPercentage(numCacheHits, numCacheLookups) << "%)" << endl;
+
+        cout << "\tNumber of visited nodes per read:" << endl;
+        for (size_t i = 0; i < numWorkBins; i++) {
+                if (workHistogram[i] == 0)
+                        continue;
+                if (i <= 1)
+                        cout << "\t\t" << i << ": ";
+                else if (i + 1 == numWorkBins)
+                        cout << "\t\t" << (size_t(1) << (i-1)) << "+: ";
+                else
+                        cout << "\t\t" << (size_t(1) << (i-1)) << "-"
+                             << (size_t(1) << i) - 1 << ": ";
+                cout << workHistogram[i] << fixed << setprecision(2) << " ("
+                     << Util::toPercentage(workHistogram[i], numReads) << "%)" << endl;
+        }
 }
 
 // ============================================================================
@@ -152,17 +191,49 @@ void ReadCorrection::findNPPFast(const string& read, vector<NodePosPair>& nppv)
                 size_t readPos = it.getOffset() + Kmer::getK();
                 size_t nodePos = npp.getOffset() + Kmer::getK();
 
-                while ((readPos < read.size()) && (nodePos < node.getLength())) {
-                        if (read[readPos] == node.getNucleotide(nodePos)) {
-                                it++;
-                                nppv[it.getOffset()] = NodePosPair(nodeID, nodePos - Kmer::getK() + 1);
-                                nodePos++;
-                                readPos++;
-                        } else
-                                break;
+                size_t maxLen = min(read.size() - readPos, node.getLength() - nodePos);
+                size_t numMatch = node.getMatchLength(nodePos, packedRead, readPos, maxLen);
+                for (size_t i = 0; i < numMatch; i++) {
+                        it++;
+                        nppv[it.getOffset()] = NodePosPair(nodeID, nodePos + i - Kmer::getK() + 1);
+                }
+        }
+}
 
+bool ReadCorrection::isSolidRead(const string& read) const
+{
+        KmerIt it(read);
+        if (!it.isValid() || (it.getOffset() != 0))
+                return false;
+
+        NodePosPair npp = dbg.getNodePosPair(it.getKmer());
+        if (!npp.isValid())
+                return false;
+
+        SSNode node = dbg.getSSNode(npp.getNodeID());
+        size_t nodePos = npp.getOffset() + Kmer::getK();
+
+        size_t readPos = Kmer::getK();
+        while (readPos < read.size()) {
+                // at the end of a node, follow the arc with the next nucleotide
+                if (nodePos == node.getLength()) {
+                        NodeID nextID = node.getRightArc(read[readPos]);
+                        if (nextID == 0)
+                                return false;
+                        node = dbg.getSSNode(nextID);
+                        nodePos = Kmer::getK();
+                        readPos++;
+                        continue;
                 }
+
+                size_t maxLen = min(read.size() - readPos, node.getLength() - nodePos);
+                if (node.getMatchLength(nodePos, packedRead, readPos, maxLen) < maxLen)
+                        return false;
+                readPos += maxLen;
+                nodePos += maxLen;
         }
+
+        return true;
 }
 
 void ReadCorrection::extractSeeds(const vector<NodePosPair>& nppv,
@@ -207,16 +278,46 @@ void ReadCorrection::extractSeeds(const vector<NodePosPair>& nppv,
         }
 }
 
-void ReadCorrection::recSearch(NodeID curr, string& read, vector<NodePosPair>& npp,
+int ReadCorrection::alignOverlap(const SSNode& node, const string& read,
+                                 const PackedSequence& packed, size_t readPos,
+                                 size_t OLSize, int minScore)
+{
+        size_t numMismatches = node.countMismatches(Kmer::getK() - 1, packed,
+                                                    readPos + Kmer::getK() - 1, OLSize);
+        if (alignment.isGaplessOptimal(numMismatches))
+                return alignment.getGaplessScore(OLSize, numMismatches);
+
+        string nodeOL = node.substr(Kmer::getK()-1, OLSize);
+        string readOL = read.substr(readPos + Kmer::getK() - 1, OLSize);
+        return alignment.alignBounded(readOL, nodeOL, minScore);
+}
+
+void ReadCorrection::recSearch(NodeID curr, string& read,
+                               const PackedSequence& packed,
+                               vector<NodePosPair>& npp,
                                   size_t currReadPos, size_t& counter,
                                   int currScore, int& bestScore, size_t& seedLast)
 {
+        // the subtree of a state that was already reached with at least the
+        // same score cannot lead to a better best score: skip it
+        uint64_t stateKey = getStateKey(curr, currReadPos);
+        if (bestStateScore.contains(stateKey) &&
+            bestStateScore.get(stateKey) >= currScore)
+                return;
+        bestStateScore[stateKey] = currScore;
+
         const SSNode node = dbg.getSSNode(curr);
 
         counter++;
         if (counter > settings.getReadCorrDFSNodeLimit())
                 return;
 
+        if (workBudget > 0 && readWork >= workBudget) {
+                overBudget = true;
+                return;
+        }
+        readWork++;
+
         vector<DFSNode> dfsNode;
 
         size_t readCharLeft = getMarginalLength(read) - currReadPos;
@@ -228,10 +329,15 @@ void ReadCorrection::recSearch(NodeID curr, string& read, vector<NodePosPair>& n
                 size_t OLSize = min(nextNode.getMarginalLength(), readCharLeft);
                 size_t nextReadPos = currReadPos + OLSize;
 
-                string nodeOL = nextNode.substr(Kmer::getK()-1, OLSize);
-                string readOL = read.substr(currReadPos + Kmer::getK() - 1, OLSize);
+                // a child that can neither improve the best score nor lead
+                // to a better one is not considered
+                int minScore = bestScore - currScore + 1 -
+                               (int)(getMarginalLength(read) - nextReadPos);
+                int thisScore = alignOverlap(nextNode, read, packed, currReadPos,
+                                             OLSize, minScore);
+                if (thisScore < minScore)
+                        continue;
 
-                int thisScore = alignment.align(readOL, nodeOL);
                 int nextScore = currScore + thisScore;
                 float nextRelScore = (float)thisScore / (float)nextNode.getMarginalLength();
 
@@ -274,7 +380,7 @@ void ReadCorrection::recSearch(NodeID curr, string& read, vector<NodePosPair>& n
 
                 // descend in a child node only if there is chance this will improve the best score
                 if (maxAttainScore > bestScore)
-                        recSearch(nextID, read, npp, nextReadPos, counter, nextScore, bestScore, seedLast);
+                        recSearch(nextID, read, packed, npp, nextReadPos, counter, nextScore, bestScore, seedLast);
 
                 // if the best score has been updated in this branch...
                 if (bestScore <= prevBestScore)
@@ -289,7 +395,117 @@ void ReadCorrection::recSearch(NodeID curr, string& read, vector<NodePosPair>& n
         }
 }
 
-void ReadCorrection::extendSeed(string& read, vector<NodePosPair>& npp,
+void ReadCorrection::bestFirstSearch(NodeID curr, const string& read,
+                                     const PackedSequence& packed,
+                                     vector<NodePosPair>& npp,
+                                     size_t& seedLast)
+{
+        const size_t readLength = getMarginalLength(read);
+        const size_t noState = numeric_limits<size_t>::max();
+
+        // states with a higher bound come first, ties are broken in favor
+        // of the deepest state to quickly find a good lower bound
+        auto worse = [this](size_t lhs, size_t rhs) {
+                const SearchState& l = statePool[lhs];
+                const SearchState& r = statePool[rhs];
+                if (l.bound != r.bound)
+                        return l.bound < r.bound;
+                return l.readPos < r.readPos;
+        };
+
+        statePool.clear();
+        openList.clear();
+        bestStateScore.clear();
+
+        int bestScore = -(int)(readLength - seedLast);
+        size_t bestState = noState;
+
+        statePool.push_back(SearchState(curr, seedLast, 0,
+                                        (int)(readLength - seedLast), noState));
+        openList.push_back(0);
+        bestStateScore[getStateKey(curr, seedLast)] = 0;
+
+        size_t numExpanded = 0;
+        while (!openList.empty()) {
+                pop_heap(openList.begin(), openList.end(), worse);
+                size_t currIdx = openList.back();
+                openList.pop_back();
+
+                // copy: the pool may be reallocated below
+                const SearchState state = statePool[currIdx];
+
+                // the bound is admissible: no open state can do better
+                if (state.bound <= bestScore)
+                        break;
+
+                if (++numExpanded > (size_t)settings.getReadCorrDFSNodeLimit())
+                        break;
+
+                if (workBudget > 0 && readWork >= workBudget) {
+                        overBudget = true;
+                        break;
+                }
+                readWork++;
+
+                const SSNode node = dbg.getSSNode(state.nodeID);
+                size_t readCharLeft = readLength - state.readPos;
+
+                for (ArcIt it = node.rightBegin(); it != node.rightEnd(); it++) {
+                        NodeID nextID = it->getNodeID();
+                        const SSNode nextNode = dbg.getSSNode(nextID);
+
+                        size_t OLSize = min(nextNode.getMarginalLength(), readCharLeft);
+                        size_t nextReadPos = state.readPos + OLSize;
+
+                        int minScore = bestScore - state.score + 1 -
+                                       (int)(readLength - nextReadPos);
+                        int thisScore = alignOverlap(nextNode, read, packed,
+                                                     state.readPos, OLSize, minScore);
+                        if (thisScore < minScore)
+                                continue;
+
+                        int nextScore = state.score + thisScore;
+
+                        // skip states that were reached before with at least
+                        // the same score
+                        uint64_t stateKey = getStateKey(nextID, nextReadPos);
+                        if (bestStateScore.contains(stateKey) &&
+                            bestStateScore.get(stateKey) >= nextScore)
+                                continue;
+                        bestStateScore[stateKey] = nextScore;
+
+                        int nextBound = nextScore + (int)(readLength - nextReadPos);
+                        statePool.push_back(SearchState(nextID, nextReadPos,
+                                                        nextScore, nextBound,
+                                                        currIdx));
+
+                        if (nextScore > bestScore) {
+                                bestScore = nextScore;
+                                bestState = statePool.size() - 1;
+                        }
+
+                        if ((nextReadPos < readLength) && (nextBound > bestScore)) {
+                                openList.push_back(statePool.size() - 1);
+                                push_heap(openList.begin(), openList.end(), worse);
+                        }
+                }
+        }
+
+        if (bestState == noState)
+                return;
+
+        // save the npp along the best path
+        seedLast = statePool[bestState].readPos;
+        for (size_t i = bestState; statePool[i].parent != noState; i = statePool[i].parent) {
+                const SearchState& state = statePool[i];
+                size_t prevReadPos = statePool[state.parent].readPos;
+                for (size_t j = prevReadPos; j < state.readPos; j++)
+                        npp[j] = NodePosPair(state.nodeID, j - prevReadPos);
+        }
+}
+
+void ReadCorrection::extendSeed(string& read, const PackedSequence& packed,
+                                vector<NodePosPair>& npp,
                                    size_t& seedFirst, size_t& seedLast)
 {
         // remove at most k nucleotides from the seed
@@ -312,9 +528,15 @@ void ReadCorrection::extendSeed(string& read, vector<NodePosPair>& npp,
         // try to find the best right path
         //if (seedLast < getMarginalLength(read))
         //      cout << read << endl;
+        if (seedLast < getMarginalLength(read) && settings.useBestFirstReadCorr()) {
+                bestFirstSearch(node.getNodeID(), read, packed, npp, seedLast);
+                return;
+        }
+
         size_t counter = 0; int bestScore = -(getMarginalLength(read) - seedLast);
+        bestStateScore.clear();
         if (seedLast < getMarginalLength(read))
-                recSearch(node.getNodeID(), read, npp, seedLast, counter, 0, bestScore, seedLast);
+                recSearch(node.getNodeID(), read, packed, npp, seedLast, counter, 0, bestScore, seedLast);
 }
 
 void ReadCorrection::applyReadCorrection(string& read,
@@ -337,7 +559,7 @@ void ReadCorrection::correctRead(string& read, vector<NodePosPair> npp,
                                     size_t& first, size_t& last)
 {
         // extend to the right
-        extendSeed(read, npp, first, last);
+        extendSeed(read, packedRead, npp, first, last);
 
         // reverse complement all data
         Nucleotide::revCompl(read);
@@ -347,7 +569,7 @@ void ReadCorrection::correctRead(string& read, vector<NodePosPair> npp,
         revCompl(npp);
 
         // extend to the right (which used to be left)
-        extendSeed(read, npp, first, last);
+        extendSeed(read, packedRevCompl, npp, first, last);
 
         Nucleotide::revCompl(read);
         first = getMarginalLength(read) - first;
@@ -414,31 +636,47 @@ bool sortByLength(const Seed& a, const Seed& b) {
 void ReadCorrection::findSeedMEM(const string& read,
                                     vector<Seed>& mergedSeeds)
 {
-        vector<match_t> matches;
+        // the index only holds the forward node sequences: matches with the
+        // reverse complement of a node are found using the reverse
+        // complement of the read (other characters, e.g. 'N', are kept)
+        string readRC(read.rbegin(), read.rend());
+        for (auto& c : readRC)
+                if ((c == 'A') || (c == 'C') || (c == 'G') || (c == 'T'))
+                        c = Nucleotide::getComplement(c);
+
+        vector<match_t> matches, matchesRC;
 
         int memSize = Kmer::getK() - 1;
-        while (matches.size() < 100 && memSize>5) {
+        while (matches.size() + matchesRC.size() < 100 && memSize>5) {
                 matches.clear();
+                matchesRC.clear();
                 //cout << "Find MEM: " << memSize << endl;
-                sa.findMEM(0l, read, matches, memSize, false);
+                sa->findMEM(0l, read, matches, memSize, false);
+                sa->findMEM(0l, readRC, matchesRC, memSize, false);
                 //cout << "Number of matches for size " << memSize << ": " << matches.size() << endl;
                 memSize--;
         }
 
+        // map the matches with the reverse complement onto the read
+        size_t numFwdMatches = matches.size();
+        matches.insert(matches.end(), matchesRC.begin(), matchesRC.end());
 
         vector<Seed> seeds;
         seeds.reserve(matches.size());
-        for (auto it : matches) {
+        for (size_t i = 0; i < matches.size(); i++) {
+                const match_t& it = matches[i];
 
                 vector<long>::const_iterator e = upper_bound(startpos.begin(), startpos.end(), it.ref);
                 e--;
                 NodeID nodeID = distance(startpos.begin(), e) + 1;
                 size_t nodeFirst = it.ref - *e;
+                size_t readFirst = it.query;
 
                 SSNode node = dbg.getSSNode(nodeID);
-                if (nodeFirst > node.getLength()) {
+                if (i >= numFwdMatches) {
                         nodeID = -nodeID;
-                        nodeFirst = nodeFirst - node.getLength() - 1;
+                        nodeFirst = node.getLength() - nodeFirst - it.len;
+                        readFirst = read.size() - readFirst - it.len;
                 }
 
                 // don't select MEMs that are closer than k nucleotides to the
@@ -446,8 +684,6 @@ void ReadCorrection::findSeedMEM(const string& read,
                 if (nodeFirst >= node.getMarginalLength())
                         continue;
 
-                size_t readFirst = it.query;
-
                 // don't select MEMs that are closer than k nucleotides to the
                 // right edge of the read: NECESSARY ?!?
                 if (readFirst >= getMarginalLength(read))
@@ -458,22 +694,7 @@ void ReadCorrection::findSeedMEM(const string& read,
                 seeds.push_back(Seed(nodeID, nodeFirst, readFirst, readEnd));
         }
 
-        // sort seeds according to nodeID
-        sort(seeds.begin(), seeds.end());
-
-        // merge seeds
-        Seed::mergeSeeds(seeds, mergedSeeds);
-
-        // sort seeds according to length
-        sort(mergedSeeds.begin(), mergedSeeds.end(), sortByLength);
-
-        // retain only 10 largest seeds
-        if (mergedSeeds.size() > 10)
-                mergedSeeds.resize(10);
-
-        for (size_t i = 0; i < mergedSeeds.size(); i++)
-                mergedSeeds[i].readEnd -= min(Kmer::getK() - 1, mergedSeeds[i].readEnd - mergedSeeds[i].readFirst - 1);
-
+        selectSeeds(seeds, mergedSeeds);
 
         // ----------- OUTPUT ------------
         /*cout << "NPP after kmer lookup search" << endl;
@@ -494,6 +715,77 @@ void ReadCorrection::findSeedMEM(const string& read,
         // ----------- OUTPUT ------------
 }
 
+void ReadCorrection::findSeedMinimizer(const string& read,
+                                       vector<Seed>& mergedSeeds)
+{
+        // as in findSeedMEM, only the forward node sequences are indexed
+        string readRC(read.rbegin(), read.rend());
+        for (auto& c : readRC)
+                if ((c == 'A') || (c == 'C') || (c == 'G') || (c == 'T'))
+                        c = Nucleotide::getComplement(c);
+
+        const size_t k = minIndex->getK();
+        const size_t maxGap = Kmer::getK();
+
+        vector<Seed> seeds;
+        vector<MinimizerHit> hits;
+        for (int strand = 0; strand < 2; strand++) {
+                minIndex->findHits((strand == 0) ? read : readRC, hits);
+
+                // chain the colinear hits per node and diagonal
+                sort(hits.begin(), hits.end());
+                for (size_t i = 0, j = 1; i < hits.size(); i = j++) {
+                        while ((j < hits.size()) &&
+                               (hits[j].nodeID == hits[i].nodeID) &&
+                               (hits[j].getDiagonal() == hits[i].getDiagonal()) &&
+                               (hits[j].seqPos <= hits[j-1].seqPos + maxGap))
+                                j++;
+
+                        NodeID nodeID = hits[i].nodeID;
+                        size_t nodeFirst = hits[i].nodePos;
+                        size_t readFirst = hits[i].seqPos;
+                        size_t len = hits[j-1].seqPos + k - readFirst;
+
+                        SSNode node = dbg.getSSNode(nodeID);
+                        if (strand == 1) {
+                                nodeID = -nodeID;
+                                nodeFirst = node.getLength() - nodeFirst - len;
+                                readFirst = read.size() - readFirst - len;
+                        }
+
+                        // same restrictions as for the MEMs
+                        if (nodeFirst >= node.getMarginalLength())
+                                continue;
+                        if (readFirst >= getMarginalLength(read))
+                                continue;
+
+                        seeds.push_back(Seed(nodeID, nodeFirst, readFirst, readFirst + len));
+                }
+        }
+
+        selectSeeds(seeds, mergedSeeds);
+}
+
+void ReadCorrection::selectSeeds(vector<Seed>& seeds,
+                                 vector<Seed>& mergedSeeds)
+{
+        // sort seeds according to nodeID
+        sort(seeds.begin(), seeds.end());
+
+        // merge seeds
+        Seed::mergeSeeds(seeds, mergedSeeds);
+
+        // sort seeds according to length
+        sort(mergedSeeds.begin(), mergedSeeds.end(), sortByLength);
+
+        // retain only 10 largest seeds
+        if (mergedSeeds.size() > 10)
+                mergedSeeds.resize(10);
+
+        for (size_t i = 0; i < mergedSeeds.size(); i++)
+                mergedSeeds[i].readEnd -= min(Kmer::getK() - 1, mergedSeeds[i].readEnd - mergedSeeds[i].readFirst - 1);
+}
+
 int ReadCorrection::correctRead(const string& read,
                                    string& bestCorrectedRead,
                                    const vector<Seed>& seeds)
@@ -529,15 +821,48 @@ int ReadCorrection::correctRead(const string& read,
         return bestScore;
 }
 
-void ReadCorrection::correctRead(ReadRecord& record,
-                                    AlignmentMetrics& metrics)
+bool ReadCorrection::correctRead(ReadRecord& record,
+                                    AlignmentMetrics& metrics, bool retry)
 {
         bool correctedByMEM = false, readCorrected = false;
         string& read = record.getRead();
 
         // if the read is too short, get out
         if (read.length() < Kmer::getK())
-                return;
+                return true;
+
+        // reads that are already a path in the graph are left untouched
+        packedRead.pack(read);
+        if (isSolidRead(read)) {
+                metrics.addSolidRead();
+                metrics.addWork(0, false);
+                return true;
+        }
+
+        // identical reads have identical corrections
+        ReadKey key;
+        if (cache != NULL) {
+                key = ReadKey(read);
+                CorrectedRead cached;
+                bool hit = cache->find(key, cached);
+                metrics.addCacheLookup(hit);
+                if (hit) {
+                        if (cached.corrected)
+                                read = cached.read;
+                        metrics.addObservation(cached.corrected, cached.corrByMEM,
+                                               cached.numSubstitutions);
+                        metrics.addWork(0, false);
+                        return true;
+                }
+        }
+
+        size_t retryBudget = settings.getReadCorrRetryBudget();
+        workBudget = (retry && retryBudget > 0) ?
+                retryBudget : settings.getReadCorrWorkBudget();
+        readWork = 0;
+        overBudget = false;
+
+        packedRevCompl.pack(read, true);
 
         vector<Seed> seeds;
         findSeedKmer(read, seeds);
@@ -545,12 +870,27 @@ void ReadCorrection::correctRead(ReadRecord& record,
         string bestCorrectedRead;
         int bestScore = correctRead(read, bestCorrectedRead, seeds);
 
-        if (bestScore <= ((int)read.size() / 2)) {
+        bool haveIndex = (sa != NULL) || (minIndex != NULL);
+
+        // the seed index is still being built: try again later
+        if (bestScore <= ((int)read.size() / 2) && !haveIndex && !retry)
+                return false;
+
+        if (bestScore <= ((int)read.size() / 2) && haveIndex) {
                 correctedByMEM = true;
-                findSeedMEM(read, seeds);
+                if (minIndex != NULL)
+                        findSeedMinimizer(read, seeds);
+                else
+                        findSeedMEM(read, seeds);
                 bestScore = correctRead(read, bestCorrectedRead, seeds);
         }
 
+        // the read exceeded the work budget: try again with the retry budget
+        if (overBudget && !retry && retryBudget > 0) {
+                metrics.addRetriedRead();
+                return false;
+        }
+
         /*alignment.align(read, bestCorrectedRead);
         cout << "BEST ALIGNMENT: " << bestScore << endl;
         alignment.printAlignment(read, bestCorrectedRead);*/
@@ -562,14 +902,29 @@ void ReadCorrection::correctRead(ReadRecord& record,
                 numSubstitutions = (read.length() - bestScore)/2;
         }
 
+        if (cache != NULL) {
+                CorrectedRead value;
+                if (readCorrected)
+                        value.read = read;
+                value.corrected = readCorrected;
+                value.corrByMEM = correctedByMEM;
+                value.numSubstitutions = numSubstitutions;
+                cache->insert(key, value);
+        }
+
         metrics.addObservation(readCorrected, correctedByMEM, numSubstitutions);
+        metrics.addWork(readWork, overBudget);
+        return true;
 }
 
 void ReadCorrection::correctChunk(vector<ReadRecord>& readChunk,
-                                     AlignmentMetrics& metrics)
+                                     AlignmentMetrics& metrics,
+                                     vector<size_t>& deferred)
 {
-        for (auto& it : readChunk)
-                correctRead(it, metrics);
+        deferred.clear();
+        for (size_t i = 0; i < readChunk.size(); i++)
+                if (!correctRead(readChunk[i], metrics, false))
+                        deferred.push_back(i);
 
         /*cout << readChunk.size() << endl;
         for (size_t i = 269; i < 270; i++) {
@@ -581,34 +936,125 @@ void ReadCorrection::correctChunk(vector<ReadRecord>& readChunk,
         exit(0);*/
 }
 
+void ReadCorrection::correctDeferred(vector<ReadRecord>& readChunk,
+                                     const vector<size_t>& deferred,
+                                     AlignmentMetrics& metrics)
+{
+        for (auto it : deferred)
+                correctRead(readChunk[it], metrics, true);
+}
+
 void ReadCorrectionHandler::workerThread(size_t myID, LibraryContainer& libraries,
                                          AlignmentMetrics& metrics)
 {
-        ReadCorrection readCorrection(dbg, settings, *sa, startpos);
+        ReadCorrection readCorrection(dbg, settings, NULL, startpos, NULL, cache);
+        bool haveIndex = false;
 
         // local storage of reads
         vector<ReadRecord> myReadBuf;
+        vector<size_t> deferred;
 
         // performance counters per thread
         AlignmentMetrics threadMetrics;
 
-        while (true) {
+        // Chunks with reads that need the seed index while it is still being
+        // built or that exceeded the work budget are set aside and finished
+        // when no other work is available. Never wait for input while holding
+        // on to such chunks: they might be holding up the I/O threads.
+        vector<DeferredChunk> deferredChunks;
+        bool result = true;
+        while (result || !deferredChunks.empty()) {
+                if (!haveIndex && waitForSeedIndex(chrono::milliseconds(0))) {
+                        readCorrection.setSeedIndex(sa, minIndex);
+                        haveIndex = true;
+                }
+
                 size_t blockID, recordID;
-                bool result = libraries.getRecordChunk(myReadBuf, blockID, recordID);
+                myReadBuf.clear();
+                if (result && deferredChunks.empty())
+                        result = libraries.getRecordChunk(myReadBuf, blockID, recordID);
+                else if (result)
+                        result = libraries.tryGetRecordChunk(myReadBuf, blockID, recordID);
+
+                if (!myReadBuf.empty()) {
+                        readCorrection.correctChunk(myReadBuf, threadMetrics, deferred);
+
+                        if (deferred.empty()) {
+                                libraries.commitRecordChunk(myReadBuf, blockID, recordID);
+                                continue;
+                        }
 
-                readCorrection.correctChunk(myReadBuf, threadMetrics);
+                        deferredChunks.push_back(DeferredChunk(blockID, recordID));
+                        deferredChunks.back().records.swap(myReadBuf);
+                        deferredChunks.back().deferred.swap(deferred);
+                        continue;
+                }
 
-                if (result)
-                        libraries.commitRecordChunk(myReadBuf, blockID, recordID);
-                else
-                        break;
+                // no work available at this point: finish the deferred chunks
+                if (deferredChunks.empty())
+                        continue;
+
+                if (!haveIndex) {
+                        if (result)     // input might become available
+                                waitForSeedIndex(chrono::milliseconds(10));
+                        else
+                                waitForSeedIndex();
+                        continue;
+                }
+
+                for (auto& it : deferredChunks) {
+                        readCorrection.correctDeferred(it.records, it.deferred, threadMetrics);
+                        libraries.commitRecordChunk(it.records, it.blockID, it.recordID);
+                }
+                deferredChunks.clear();
         }
 
         // update the global metrics with the thread info (thread-safe)
         metrics.addMetrics(threadMetrics);
 }
 
-void ReadCorrectionHandler::initEssaMEM()
+bool ReadCorrectionHandler::waitForSeedIndex(chrono::milliseconds timeout)
+{
+        unique_lock<mutex> lock(indexMutex);
+        return indexReadyCond.wait_for(lock, timeout, [this]{return indexReady;});
+}
+
+void ReadCorrectionHandler::waitForSeedIndex()
+{
+        unique_lock<mutex> lock(indexMutex);
+        indexReadyCond.wait(lock, [this]{return indexReady;});
+}
+
+void ReadCorrectionHandler::indexThreadEntry(const string& indexFilename)
+{
+        auto startTime = chrono::system_clock::now();
+
+        // exceptions are passed on to doErrorCorrection(); the deferred
+        // reads are then simply not corrected
+        bool loaded = false;
+        exception_ptr error;
+        try {
+                if (settings.getMinimizerWindowSize() > 0)
+                        initMinimizerIndex();
+                else
+                        loaded = initEssaMEM(indexFilename);
+        } catch (...) {
+                error = current_exception();
+                delete sa; sa = NULL;
+                delete minIndex; minIndex = NULL;
+        }
+
+        chrono::duration<double> elapsed = chrono::system_clock::now() - startTime;
+
+        lock_guard<mutex> lock(indexMutex);
+        indexLoaded = loaded;
+        indexError = error;
+        indexTime = elapsed.count();
+        indexReady = true;
+        indexReadyCond.notify_all();
+}
+
+void ReadCorrectionHandler::initStartPos()
 {
         size_t length = 0;
         startpos.clear();
@@ -617,22 +1063,38 @@ void ReadCorrectionHandler::initEssaMEM()
                 SSNode node = dbg.getSSNode(nodeID);
                 assert(node.isValid());
                 startpos.push_back(length);
-                length += node.getLength() * 2 + 2;
+                length += node.getLength() + 1;
+        }
+
+        // the index arrays are 32-bit, both the text positions and the
+        // number of sampled suffixes (including the '$' padding) must fit
+        if ((long)length > sparseSA::max_text_length())
+                throw runtime_error("The graph is too large for the suffix "
+                                    "array, use the minimizer index (-m)");
+
+        long sparseness = settings.getEssaMEMSparsenessFactor();
+        if ((long)length / sparseness + 2 > sparseSA::max_num_suffixes())
+                throw runtime_error("The graph is too large for the suffix "
+                                    "array, increase the sparseness factor (-e)");
+}
+
+bool ReadCorrectionHandler::initEssaMEM(const string& indexFilename)
+{
+        size_t length = 0;
+        if (!startpos.empty()) {
+                SSNode last = dbg.getSSNode(dbg.getNumNodes());
+                length = startpos.back() + last.getLength() + 1;
         }
 
         reference.clear();
         reference.reserve(length);
-        for (NodeID nodeID = 1; nodeID < dbg.getNumNodes(); nodeID++) {
+        for (NodeID nodeID = 1; nodeID <= dbg.getNumNodes(); nodeID++) {
                 SSNode node = dbg.getSSNode(nodeID);
                 if (!node.isValid())
                         continue;
 
-                string thisSequence = node.getSequence();
-                reference.append(thisSequence);
-                reference.append(">");
-
-                Nucleotide::revCompl(thisSequence);
-                reference.append(thisSequence);
+                // only the forward strand: see findSeedMEM
+                reference.append(node.getSequence());
                 reference.append(">");
         }
 
@@ -656,7 +1118,31 @@ void ReadCorrectionHandler::initEssaMEM()
                           printRevCompForw,
                           false                                 // nucleotides only
                           );
-        sa->construct();
+
+        if (sa->loadMapped(indexFilename))
+                return true;
+
+        sa->construct(settings.getNumThreads());
+        if (!sa->saveMapped(indexFilename))
+                cerr << "WARNING: could not write the suffix array to "
+                     << indexFilename << endl;
+        return false;
+}
+
+void ReadCorrectionHandler::initMinimizerIndex()
+{
+        size_t k = min<size_t>(15, Kmer::getK());
+        minIndex = new MinimizerIndex(k, settings.getMinimizerWindowSize());
+
+        for (NodeID nodeID = 1; nodeID <= dbg.getNumNodes(); nodeID++) {
+                SSNode node = dbg.getSSNode(nodeID);
+                if (!node.isValid())
+                        continue;
+
+                minIndex->addSequence(nodeID, node.getSequence());
+        }
+
+        minIndex->finalize();
 }
 
 void ReadCorrectionHandler::doErrorCorrection(LibraryContainer& libraries)
@@ -680,26 +1166,69 @@ void ReadCorrectionHandler::doErrorCorrection(LibraryContainer& libraries)
 
         libraries.joinIOThreads();
 
+        indexThread.join();
+        if (indexError)
+                rethrow_exception(indexError);
+
+        if (minIndex != NULL)
+                cout << "Minimizer index created in the background ("
+                     << minIndex->getNumEntries() << " minimizers, "
+                     << Util::humRead(indexTime) << ")" << endl;
+        else
+                cout << "Suffix array " << (indexLoaded ? "loaded from file" : "created")
+                     << " in the background (" << Util::humRead(indexTime) << ")" << endl;
+
         metrics.printStatistics();
 }
 
-ReadCorrectionHandler::ReadCorrectionHandler(DBGraph& g, const Settings& s) :
-        dbg(g), settings(s), sa(NULL)
+ReadCorrectionHandler::ReadCorrectionHandler(DBGraph& g, const Settings& s,
+                                             const string& indexFilename) :
+        dbg(g), settings(s), sa(NULL), minIndex(NULL), cache(NULL),
+        indexReady(false), indexLoaded(false), indexTime(0.0)
 {
-        Util::startChrono();
-        cout << "Creating kmer lookup table... "; cout.flush();
-        dbg.populateTable();
-        cout << "done (" << Util::stopChronoStr() << ")" << endl;
+        if (settings.getReadCacheSize() > 0)
+                cache = new ReadCache(settings.getReadCacheSize());
+
+        // the seed index is built in the background, concurrently with the
+        // kmer lookup table and the first reads (see workerThread). The
+        // destructor is not called when the constructor throws, so the
+        // index thread must be joined before the exception is passed on.
+        try {
+                if (settings.getMinimizerWindowSize() > 0) {
+                        cout << "Creating minimizer index (window size: "
+                             << settings.getMinimizerWindowSize() << ") in the background" << endl;
+                } else {
+                        initStartPos();
+                        cout << "Creating suffix array (sparseness factor: "
+                             << settings.getEssaMEMSparsenessFactor() << ") in the background" << endl;
+                }
 
-        Util::startChrono();
-        cout << "Building suffix array (sparseness factor: "
-             << settings.getEssaMEMSparsenessFactor() << ")..."; cout.flush();
-        initEssaMEM();
-        cout << "done (" << Util::stopChronoStr() << ")" << endl;
+                indexThread = thread(&ReadCorrectionHandler::indexThreadEntry,
+                                     this, indexFilename);
+
+                Util::startChrono();
+                cout << "Creating kmer lookup table... "; cout.flush();
+                dbg.populateTable();
+                cout << "done (" << Util::stopChronoStr() << ")" << endl;
+        } catch (...) {
+                if (indexThread.joinable())
+                        indexThread.join();
+
+                delete sa;
+                delete minIndex;
+                delete cache;
+                dbg.depopulateTable();
+                throw;
+        }
 }
 
 ReadCorrectionHandler::~ReadCorrectionHandler()
 {
+        if (indexThread.joinable())
+                indexThread.join();
+
         delete sa;
+        delete minIndex;
+        delete cache;
         dbg.depopulateTable();
 }
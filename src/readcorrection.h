@@ -24,9 +24,16 @@
 #include "settings.h"
 #include "graph.h"
 #include "alignment.h"
+#include "scratchmap.h"
+#include "minimizerindex.h"
+#include "readcache.h"
 #include "essaMEM-master/sparseSA.hpp"
 
 #include <mutex>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <condition_variable>
 
 // ============================================================================
 // CLASS PROTOTYPES
@@ -45,6 +52,13 @@ private:
         size_t numCorrReads;            // number of reads corrected
         size_t numCorrByMEM;            // number of times MEM procedure was used
         size_t numSubstitutions;        // number of substitutions made to the reads
+        size_t numSolidReads;           // number of reads found as-is in the graph
+        size_t numOverBudget;           // number of reads that exceeded the work budget
+        size_t numRetried;              // number of reads retried with the retry budget
+        size_t numCacheLookups;         // number of duplicate read cache lookups
+        size_t numCacheHits;            // number of duplicate read cache hits
+        static const size_t numWorkBins = 24;
+        size_t workHistogram[numWorkBins];      // log2 histogram of the work per read
         std::mutex metricMutex;         // mutex for merging metrics
 
 public:
@@ -52,7 +66,9 @@ public:
          * Default constructor
          */
         AlignmentMetrics() : numReads(0), numCorrReads(0), numCorrByMEM(0),
-                numSubstitutions(0) {}
+                numSubstitutions(0), numSolidReads(0), numOverBudget(0),
+                numRetried(0), numCacheLookups(0), numCacheHits(0),
+                workHistogram() {}
 
         /**
          * Update the statistics
@@ -70,6 +86,50 @@ public:
                 numSubstitutions += numSubstitutions_;
         }
 
+        /**
+         * Update the statistics for a read that is a path in the graph
+         * (counted as a read that was corrected without substitutions)
+         */
+        void addSolidRead() {
+                numReads++;
+                numCorrReads++;
+                numSolidReads++;
+        }
+
+        /**
+         * Update the work statistics
+         * @param work Number of visited (-b: expanded) nodes for this read
+         * @param overBudget True if the read exceeded the work budget
+         */
+        void addWork(size_t work, bool overBudget) {
+                size_t bin = 0;
+                while (work > 0 && bin + 1 < numWorkBins) {
+                        work >>= 1;
+                        bin++;
+                }
+                workHistogram[bin]++;
+                if (overBudget)
+                        numOverBudget++;
+        }
+
+        /**
+         * Update the statistics for a read that exceeded the work budget
+         * and will be retried with the retry budget
+         */
+        void addRetriedRead() {
+                numRetried++;
+        }
+
+        /**
+         * Update the duplicate read cache statistics
+         * @param hit True if the read was found in the cache
+         */
+        void addCacheLookup(bool hit) {
+                numCacheLookups++;
+                if (hit)
+                        numCacheHits++;
+        }
+
         /**
          * Add other metrics (thread-safe)
          * @param metrics Metrics to add
@@ -108,6 +168,14 @@ public:
                 return numSubstitutions;
         }
 
+        /**
+         * Get the number of reads that were found as-is in the graph
+         * @return The number of reads that were found as-is in the graph
+         */
+        size_t getNumSolidReads() const {
+                return numSolidReads;
+        }
+
         /**
          * Output statistics to the stdout
          */
@@ -175,6 +243,24 @@ public:
         }
 };
 
+// ============================================================================
+// SEARCH STATE CLASS
+// ============================================================================
+
+class SearchState
+{
+public:
+        NodeID nodeID;          // node in the graph
+        size_t readPos;         // read position up to which the read is aligned
+        int score;              // alignment score from the seed onwards
+        int bound;              // upper bound on the score of any extension
+        size_t parent;          // index of the parent state in the pool
+
+        SearchState(NodeID nodeID_, size_t readPos_, int score_, int bound_,
+                    size_t parent_) : nodeID(nodeID_), readPos(readPos_),
+                    score(score_), bound(bound_), parent(parent_) {}
+};
+
 // ============================================================================
 // READ CORRECTION CLASS
 // ============================================================================
@@ -185,8 +271,18 @@ private:
         const DBGraph &dbg;
         const Settings &settings;
         AlignmentJan alignment;
-        const sparseSA& sa;
+        ScratchMap<uint64_t, int> bestStateScore;       // DFS memo (per read)
+        std::vector<SearchState> statePool;     // states of the best-first search
+        std::vector<size_t> openList;           // heap of states to expand
+        PackedSequence packedRead;              // read being corrected
+        PackedSequence packedRevCompl;          // its reverse complement
+        const sparseSA* sa;                     // essaMEM seed index (or NULL)
         const std::vector<long>& startpos;
+        const MinimizerIndex* minIndex;         // minimizer seed index (or NULL)
+        size_t workBudget;              // visited nodes per read (0 = no limit)
+        size_t readWork;                // visited nodes for the current read
+        bool overBudget;                // current read exceeded the work budget
+        ReadCache* cache;               // duplicate read cache (or NULL)
 
         /**
          * Get the marginal length of a string
@@ -196,6 +292,16 @@ private:
                 return str.length() + 1 - Kmer::getK();
         }
 
+        /**
+         * Get the memo key of a (node, read position) DFS state
+         * @param nodeID Node identifier
+         * @param readPos Position in the read
+         * @return Key that uniquely identifies the state
+         */
+        static uint64_t getStateKey(NodeID nodeID, size_t readPos) {
+                return ((uint64_t)(uint32_t)nodeID << 32) | (uint64_t)readPos;
+        }
+
         /**
          * Find the node position pairs for a read
          * @param read Reference to the read
@@ -204,12 +310,22 @@ private:
         void findNPPSlow(const std::string& read, std::vector<NodePosPair>& npp);
 
         /**
-         * Find the node position pairs for a read
-         * @param read Reference to the read
+         * Find the node position pairs for a read, matches are extended
+         * through the nodes 32 nucleotides at a time
+         * @param read Reference to the read (packed in packedRead)
          * @param npp Vector of node position pairs
          */
         void findNPPFast(const std::string& read, std::vector<NodePosPair>& npp);
 
+        /**
+         * Check if a read spells a path in the graph. Only the first kmer
+         * is looked up, the rest of the read is matched by walking the
+         * nodes and arcs.
+         * @param read Reference to the read (packed in packedRead)
+         * @return True if every kmer of the read lies on a single path
+         */
+        bool isSolidRead(const std::string& read) const;
+
         /**
          * Correct a specific read record
          * @param TODO
@@ -221,8 +337,14 @@ private:
          * Correct a specific read record
          * @param record Record to correct (input/output)
          * @param metric Alignment metric to update (input/output)
+         * @param retry True if the read was deferred before, it is then
+         * corrected using the retry budget and never deferred again
+         * @return False if the read needs the seed index, which is not
+         * available yet, or if it exceeded the work budget and should be
+         * retried (the record is left untouched)
          */
-        void correctRead(ReadRecord& record, AlignmentMetrics& metric);
+        bool correctRead(ReadRecord& record, AlignmentMetrics& metric,
+                         bool retry);
 
         /**
          * Correct the records in one chunk
@@ -239,9 +361,26 @@ private:
          * @param first First position of the seed (output)
          * @param last Last position of the seed (output)
          */
-        void extendSeed(std::string& read, std::vector<NodePosPair>& npp,
+        void extendSeed(std::string& read, const PackedSequence& packed,
+                        std::vector<NodePosPair>& npp,
                         size_t& first, size_t& last);
 
+        /**
+         * Align the part of a read that overlaps with a node. A gapless
+         * pre-score (word-wise mismatch count) is used when no gapped
+         * alignment can beat it, the banded DP otherwise.
+         * @param node Node under consideration
+         * @param read Read under consideration
+         * @param packed The read in packed form
+         * @param readPos Marginal read position where the node starts
+         * @param OLSize Size of the overlap
+         * @param minScore Minimum score of interest (see alignBounded)
+         * @return The alignment score or an upper bound below minScore
+         */
+        int alignOverlap(const SSNode& node, const std::string& read,
+                         const PackedSequence& packed, size_t readPos,
+                         size_t OLSize, int minScore);
+
         /**
          * Find the largest consecutive run and use this as seed
          * @param read Reference to the read
@@ -254,10 +393,27 @@ private:
                               const std::vector<NodePosPair>& npp,
                               size_t first, size_t last);
 
-        void recSearch(NodeID curr, string& read, vector<NodePosPair>& npp,
+        void recSearch(NodeID curr, string& read, const PackedSequence& packed,
+                       vector<NodePosPair>& npp,
                        size_t currPos, size_t& counter, int score,
                        int& bestScore, size_t& seedLast);
 
+        /**
+         * Find the best right path from a node using a best-first search
+         * (alternative to recSearch). States are expanded in order of
+         * decreasing upper bound (score + number of read positions left),
+         * so the search stops as soon as no open state can improve the best
+         * score or the expansion budget is exhausted.
+         * @param curr Node identifier in which the read is anchored
+         * @param read Read under consideration
+         * @param packed The read in packed form
+         * @param npp Node position pairs of the read (output)
+         * @param seedLast Last position of the seed (input/output)
+         */
+        void bestFirstSearch(NodeID curr, const string& read,
+                             const PackedSequence& packed,
+                             vector<NodePosPair>& npp, size_t& seedLast);
+
         void revCompl(vector<NodePosPair>& npp);
 
         void findSeedKmer(const std::string& read,
@@ -270,6 +426,23 @@ private:
          */
         void findSeedMEM(const std::string& read, std::vector<Seed>& seeds);
 
+        /**
+         * Find seeds for a read using the minimizer index. Minimizer hits on
+         * the same node and diagonal that are less than k nucleotides apart
+         * are chained into a single (gapless) seed.
+         * @param read Reference to the read
+         * @param seeds Vector of seeds to which the new seeds are added
+         */
+        void findSeedMinimizer(const std::string& read, std::vector<Seed>& seeds);
+
+        /**
+         * Merge consistent seeds and retain the 10 longest ones
+         * @param seeds Vector of seeds (sorted on output)
+         * @param mergedSeeds Vector to which the merged seeds are added
+         */
+        void selectSeeds(std::vector<Seed>& seeds,
+                         std::vector<Seed>& mergedSeeds);
+
         int correctRead(const std::string& read,
                         std::string& bestCorrectedRead,
                         const std::vector<Seed>& seeds);
@@ -279,19 +452,50 @@ public:
          * Default constructor
          * @param dbg_ Reference to the De Bruijn graph
          * @param settings_ Reference to the settings class
+         * @param sa_ Pointer to the essaMEM index (or NULL)
+         * @param startpos_ Start position of each node in the essaMEM index
+         * @param minIndex_ Pointer to the minimizer index (or NULL)
+         * @param cache_ Pointer to the duplicate read cache (or NULL)
          */
         ReadCorrection(const DBGraph& dbg_, const Settings& settings_,
-                          const sparseSA& sa_, const std::vector<long>& startpos_) :
+                          const sparseSA* sa_, const std::vector<long>& startpos_,
+                          const MinimizerIndex* minIndex_, ReadCache* cache_) :
                           dbg(dbg_), settings(settings_),
-                          alignment(100, 2, 1, -1, -3), sa(sa_), startpos(startpos_) {}
+                          alignment(100, 2, 1, -1, -3), sa(sa_), startpos(startpos_),
+                          minIndex(minIndex_), workBudget(0), readWork(0),
+                          overBudget(false), cache(cache_) {}
+
+        /**
+         * Set the seed index once it is available
+         * @param sa_ Pointer to the essaMEM index (or NULL)
+         * @param minIndex_ Pointer to the minimizer index (or NULL)
+         */
+        void setSeedIndex(const sparseSA* sa_, const MinimizerIndex* minIndex_) {
+                sa = sa_;
+                minIndex = minIndex_;
+        }
 
         /**
          * Correct the records in one chunk
          * @param readChunk Chunk of records to correct
          * @param metric Alignment metric to update
+         * @param deferred Records that need the seed index, which is not
+         * available yet, or that exceeded the work budget (output)
          */
         void correctChunk(std::vector<ReadRecord>& readChunk,
-                          AlignmentMetrics& metric);
+                          AlignmentMetrics& metric,
+                          std::vector<size_t>& deferred);
+
+        /**
+         * Correct the records of a chunk that were deferred by correctChunk()
+         * using the retry budget, the seed index must be available
+         * @param readChunk Chunk of records to correct
+         * @param deferred Records to correct
+         * @param metric Alignment metric to update
+         */
+        void correctDeferred(std::vector<ReadRecord>& readChunk,
+                             const std::vector<size_t>& deferred,
+                             AlignmentMetrics& metric);
 };
 
 // ============================================================================
@@ -306,8 +510,71 @@ private:
         sparseSA *sa;
         std::string reference;
         std::vector<long> startpos;
+        MinimizerIndex *minIndex;
+        ReadCache *cache;                       // duplicate read cache (or NULL)
+
+        // the seed index is built by a separate thread (protect by indexMutex)
+        std::thread indexThread;                // seed index thread
+        std::mutex indexMutex;                  // seed index mutex
+        std::condition_variable indexReadyCond; // seed index ready condition
+        bool indexReady;                        // seed index is ready
+        bool indexLoaded;                       // suffix array loaded from file
+        std::exception_ptr indexError;          // exception during construction
+        double indexTime;                       // construction time (s)
 
-        void initEssaMEM();
+        /**
+         * A chunk with records that wait for the seed index
+         */
+        class DeferredChunk
+        {
+        public:
+                std::vector<ReadRecord> records;        // chunk of records
+                std::vector<size_t> deferred;           // records to correct
+                size_t blockID;                         // block identifier
+                size_t recordID;                        // record offset
+
+                DeferredChunk(size_t blockID_, size_t recordID_) :
+                        blockID(blockID_), recordID(recordID_) {}
+        };
+
+        /**
+         * Compute the start position of each node in the essaMEM reference
+         * @throws runtime_error if the graph is too large for the suffix array
+         */
+        void initStartPos();
+
+        /**
+         * Create the essaMEM index of the graph. An index file that matches
+         * the graph is memory mapped, otherwise the index is built and
+         * written to that file for subsequent runs. The start positions
+         * must have been computed by initStartPos().
+         * @param indexFilename Filename of the persistent index
+         * @return True if the index was loaded from file
+         */
+        bool initEssaMEM(const std::string& indexFilename);
+
+        /**
+         * Create the minimizer index of the graph (alternative to essaMEM)
+         */
+        void initMinimizerIndex();
+
+        /**
+         * Entry routine for the thread that builds the seed index
+         * @param indexFilename Filename of the persistent essaMEM index
+         */
+        void indexThreadEntry(const std::string& indexFilename);
+
+        /**
+         * Wait until the seed index is ready
+         * @param timeout Maximum time to wait
+         * @return True if the seed index is ready
+         */
+        bool waitForSeedIndex(std::chrono::milliseconds timeout);
+
+        /**
+         * Wait until the seed index is ready
+         */
+        void waitForSeedIndex();
 
         /**
          * Entry routine for worker thread
@@ -321,8 +588,12 @@ private:
 public:
         /**
          * Default constructor
+         * @param g Reference to the De Bruijn graph
+         * @param s Reference to the settings class
+         * @param indexFilename Filename of the persistent essaMEM index
          */
-        ReadCorrectionHandler(DBGraph& g, const Settings& s);
+        ReadCorrectionHandler(DBGraph& g, const Settings& s,
+                              const std::string& indexFilename);
 
         /**
          * Destructor
@@ -0,0 +1,165 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SCRATCHMAP_H
+#define SCRATCHMAP_H
+
+#include "global.h"
+
+#include <vector>
+#include <utility>
+
+// ============================================================================
+// SCRATCH MAP CLASS
+// ============================================================================
+
+/**
+ * Small open addressing hash map (linear probing) with integer keys, meant
+ * as reusable scratch space for local graph searches. Clearing the map only
+ * resets the slots that were used since the previous clear, so the cost of a
+ * search no longer depends on the size of the graph.
+ */
+template<class Key, class Value>
+class ScratchMap {
+
+private:
+        std::vector<Key> keys;          // key of each slot
+        std::vector<Value> values;      // value of each slot
+        std::vector<bool> used;         // true if a slot is occupied
+        std::vector<size_t> touched;    // indices of the occupied slots
+        size_t numBits;                 // log2 of the number of slots
+
+        /**
+         * Get the home slot of a key (Fibonacci hashing)
+         * @param key Key
+         * @return Slot index
+         */
+        size_t getHome(Key key) const {
+                return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull)
+                                >> (64 - numBits));
+        }
+
+        /**
+         * Find the slot of a key or the empty slot where it should go
+         * @param key Key
+         * @return Slot index
+         */
+        size_t findSlot(Key key) const {
+                size_t mask = keys.size() - 1;
+                size_t slot = getHome(key);
+                while (used[slot] && (keys[slot] != key))
+                        slot = (slot + 1) & mask;
+                return slot;
+        }
+
+        /**
+         * Double the number of slots and reinsert all elements
+         */
+        void grow() {
+                ScratchMap<Key, Value> larger(2 * keys.size());
+                for (size_t i = 0; i < touched.size(); i++)
+                        larger[keys[touched[i]]] = values[touched[i]];
+                *this = std::move(larger);
+        }
+
+public:
+        /**
+         * Default constructor
+         * @param minCapacity Initial number of slots (rounded to a power of 2)
+         */
+        ScratchMap(size_t minCapacity = 64) : numBits(1) {
+                while (((size_t)1 << numBits) < minCapacity)
+                        numBits++;
+                keys.resize((size_t)1 << numBits);
+                values.resize((size_t)1 << numBits);
+                used.resize((size_t)1 << numBits, false);
+        }
+
+        /**
+         * Check if a key is present
+         * @param key Key
+         * @return True if the key is present
+         */
+        bool contains(Key key) const {
+                return used[findSlot(key)];
+        }
+
+        /**
+         * Get the value of a key
+         * @param key Key
+         * @return The value of the key or Value() if the key is absent
+         */
+        Value get(Key key) const {
+                size_t slot = findSlot(key);
+                return used[slot] ? values[slot] : Value();
+        }
+
+        /**
+         * Get a reference to the value of a key, the key is inserted with
+         * value Value() if it is absent
+         * @param key Key
+         * @return Reference to the value
+         */
+        Value& operator[](Key key) {
+                size_t slot = findSlot(key);
+                if (used[slot])
+                        return values[slot];
+
+                // keep the load factor at most 1/2
+                if (2 * (touched.size() + 1) > keys.size()) {
+                        grow();
+                        slot = findSlot(key);
+                }
+
+                keys[slot] = key;
+                values[slot] = Value();
+                used[slot] = true;
+                touched.push_back(slot);
+                return values[slot];
+        }
+
+        /**
+         * Get the number of elements
+         * @return The number of elements
+         */
+        size_t size() const {
+                return touched.size();
+        }
+
+        /**
+         * Check if the map is empty
+         * @return True if the map is empty
+         */
+        bool empty() const {
+                return touched.empty();
+        }
+
+        /**
+         * Remove all elements in O(size()) time
+         */
+        void clear() {
+                for (size_t i = 0; i < touched.size(); i++)
+                        used[touched[i]] = false;
+                touched.clear();
+        }
+};
+
+#endif
@@ -0,0 +1,334 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "sequencearena.h"
+
+#include <cstring>
+
+using namespace std;
+
+// ============================================================================
+// PACKED SEQUENCE CLASS
+// ============================================================================
+
+void PackedSequence::pack(const string& str, bool revCompl)
+{
+        length = str.size();
+
+        size_t numWords = (length + 31) / 32 + 1;
+        words.assign(numWords, 0);
+        invalid.assign(numWords, 0);
+        wildcard.assign(numWords, 0);
+
+        for (size_t i = 0; i < length; i++) {
+                char c = revCompl ? str[length - i - 1] : str[i];
+                size_t shift = 2 * (i % 32);
+                if ((c != 'A') && (c != 'C') && (c != 'G') && (c != 'T')) {
+                        invalid[i / 32] |= uint64_t(1) << shift;
+                        if (c == 'N')
+                                wildcard[i / 32] |= uint64_t(1) << shift;
+                        continue;
+                }
+
+                uint64_t n = Nucleotide::charToNucleotide(c);
+                if (revCompl)
+                        n = 3 - n;
+                words[i / 32] |= n << shift;
+        }
+}
+
+// ============================================================================
+// SEQUENCE ARENA CLASS (PRIVATE)
+// ============================================================================
+
+void SequenceArena::release(size_t id)
+{
+        size_t numWords = getNumWords(lengths[id]);
+        if (numWords == 0 || lengthsOnly)
+                return;
+
+        // the final sequence in the arena can simply be popped
+        if (offsets[id] + numWords == numUsedWords) {
+                memset(words.data() + offsets[id], 0, numWords * sizeof(uint64_t));
+                numUsedWords -= numWords;
+        } else {
+                numDeadWords += numWords;
+        }
+}
+
+// ============================================================================
+// SEQUENCE ARENA CLASS (PUBLIC)
+// ============================================================================
+
+void SequenceArena::reset(size_t numSequences, size_t expNumNucleotides)
+{
+        clear();
+
+        offsets.resize(numSequences, 0);
+        lengths.resize(numSequences, 0);
+
+        // every sequence can waste up to one word
+        words.reserve(getNumWords(expNumNucleotides) + numSequences + 1);
+        growWords();
+}
+
+void SequenceArena::clear()
+{
+        vector<uint64_t>().swap(words);
+        vector<uint64_t>().swap(offsets);
+        vector<uint32_t>().swap(lengths);
+        numUsedWords = numDeadWords = 0;
+        lengthsOnly = false;
+}
+
+void SequenceArena::cloneLengths(const SequenceArena& source)
+{
+        clear();
+
+        offsets.resize(source.lengths.size(), 0);
+        lengths = source.lengths;
+        lengthsOnly = true;
+}
+
+size_t SequenceArena::getMatchLength(size_t id, size_t pos, bool revCompl,
+                                     const PackedSequence& str,
+                                     size_t strPos, size_t maxLen) const
+{
+        assert(!lengthsOnly);
+        assert(pos + maxLen <= lengths[id]);
+        assert(strPos + maxLen <= str.getLength());
+
+        for (size_t i = 0; i < maxLen; i += 32) {
+                size_t num = min<size_t>(32, maxLen - i);
+                uint64_t diff = getMismatchMask(getOrientedWord(id, pos + i, num, revCompl),
+                                                str.getWord(strPos + i));
+                diff |= str.getInvalidWord(strPos + i);
+                if (num < 32)
+                        diff &= (uint64_t(1) << (2 * num)) - 1;
+                if (diff != 0)
+                        return i + __builtin_ctzll(diff) / 2;
+        }
+
+        return maxLen;
+}
+
+size_t SequenceArena::countMismatches(size_t id, size_t pos, bool revCompl,
+                                      const PackedSequence& str,
+                                      size_t strPos, size_t len) const
+{
+        assert(!lengthsOnly);
+        assert(pos + len <= lengths[id]);
+        assert(strPos + len <= str.getLength());
+
+        size_t numMismatches = 0;
+        for (size_t i = 0; i < len; i += 32) {
+                size_t num = min<size_t>(32, len - i);
+                uint64_t diff = getMismatchMask(getOrientedWord(id, pos + i, num, revCompl),
+                                                str.getWord(strPos + i));
+                diff |= str.getInvalidWord(strPos + i);
+                diff &= ~str.getWildcardWord(strPos + i);
+                if (num < 32)
+                        diff &= (uint64_t(1) << (2 * num)) - 1;
+                numMismatches += __builtin_popcountll(diff);
+        }
+
+        return numMismatches;
+}
+
+void SequenceArena::setSequence(size_t id, const string& str)
+{
+        assert(!lengthsOnly);
+        size_t offset = allocate(str.size());
+
+        uint64_t *w = words.data() + offset;
+        for (size_t i = 0; i < str.size(); i++)
+                w[i / 32] |= uint64_t(Nucleotide::charToNucleotide(str[i])) << (2 * (i % 32));
+
+        assign(id, offset, str.size());
+}
+
+string SequenceArena::substr(size_t id, size_t offset, size_t len) const
+{
+        assert(!lengthsOnly);
+        if (offset >= lengths[id])
+                return string();
+
+        len = min<size_t>(len, lengths[id] - offset);
+        string result(len, 'A');
+
+        const uint64_t *w = words.data() + offsets[id];
+        for (size_t i = offset; i < offset + len; i++)
+                result[i - offset] = Nucleotide::nucleotideToChar(w[i / 32] >> (2 * (i % 32)));
+
+        return result;
+}
+
+size_t SequenceArena::allocate(size_t length)
+{
+        if (lengthsOnly)
+                return 0;
+
+        size_t offset = numUsedWords;
+        numUsedWords += getNumWords(length);
+        growWords();
+
+        return offset;
+}
+
+void SequenceArena::copy(size_t dstOffset, size_t dstPos, size_t srcID,
+                         size_t srcPos, size_t len, bool revCompl)
+{
+        assert(srcPos + len <= lengths[srcID]);
+        if (lengthsOnly)
+                return;
+
+        size_t srcOffset = offsets[srcID];
+
+        for (size_t i = 0; i < len; i += 32) {
+                size_t num = min<size_t>(32, len - i);
+                uint64_t value;
+                if (!revCompl) {
+                        value = getWord(srcOffset, srcPos + i);
+                } else {
+                        // the final nucleotides of the source go first
+                        value = getWord(srcOffset, srcPos + len - i - num);
+                        value = revComplWord(value) >> (2 * (32 - num));
+                }
+                orWord(dstOffset, dstPos + i, value, num);
+        }
+}
+
+void SequenceArena::assign(size_t id, size_t offset, size_t length)
+{
+        release(id);
+
+        offsets[id] = offset;
+        lengths[id] = length;
+}
+
+void SequenceArena::append(size_t dstID, size_t srcID, size_t srcPos,
+                           size_t len, bool revCompl)
+{
+        size_t dstLength = lengths[dstID];
+        size_t dstNumWords = getNumWords(dstLength);
+
+        // the destination sequence is at the end: extend it in place
+        if ((dstNumWords > 0) && (offsets[dstID] + dstNumWords == numUsedWords)) {
+                numUsedWords += getNumWords(dstLength + len) - dstNumWords;
+                growWords();
+                copy(offsets[dstID], dstLength, srcID, srcPos, len, revCompl);
+                lengths[dstID] = dstLength + len;
+                return;
+        }
+
+        size_t offset = allocate(dstLength + len);
+        copy(offset, 0, dstID, 0, dstLength, false);
+        copy(offset, dstLength, srcID, srcPos, len, revCompl);
+        assign(dstID, offset, dstLength + len);
+        reclaim();
+}
+
+void SequenceArena::compact()
+{
+        if (lengthsOnly)
+                return;
+
+        size_t numLiveWords = 0;
+        for (size_t id = 0; id < lengths.size(); id++)
+                numLiveWords += getNumWords(lengths[id]);
+
+        vector<uint64_t> newWords(numLiveWords + 1, 0);
+        size_t newOffset = 0;
+        for (size_t id = 0; id < lengths.size(); id++) {
+                size_t numWords = getNumWords(lengths[id]);
+                memcpy(newWords.data() + newOffset, words.data() + offsets[id],
+                       numWords * sizeof(uint64_t));
+                offsets[id] = newOffset;
+                newOffset += numWords;
+        }
+
+        words.swap(newWords);
+        numUsedWords = numLiveWords;
+        numDeadWords = 0;
+}
+
+void SequenceArena::compact(const vector<size_t>& order)
+{
+        if (lengthsOnly) {
+                vector<uint32_t> newLengths(order.size());
+                for (size_t i = 0; i < order.size(); i++)
+                        newLengths[i] = lengths[order[i]];
+                lengths.swap(newLengths);
+                offsets.assign(order.size(), 0);
+                return;
+        }
+
+        size_t numLiveWords = 0;
+        for (size_t i = 0; i < order.size(); i++)
+                numLiveWords += getNumWords(lengths[order[i]]);
+
+        vector<uint64_t> newWords(numLiveWords + 1, 0);
+        vector<uint64_t> newOffsets(order.size(), 0);
+        vector<uint32_t> newLengths(order.size(), 0);
+        size_t newOffset = 0;
+        for (size_t i = 0; i < order.size(); i++) {
+                size_t numWords = getNumWords(lengths[order[i]]);
+                memcpy(newWords.data() + newOffset,
+                       words.data() + offsets[order[i]],
+                       numWords * sizeof(uint64_t));
+                newOffsets[i] = newOffset;
+                newLengths[i] = lengths[order[i]];
+                newOffset += numWords;
+        }
+
+        words.swap(newWords);
+        offsets.swap(newOffsets);
+        lengths.swap(newLengths);
+        numUsedWords = numLiveWords;
+        numDeadWords = 0;
+}
+
+void SequenceArena::write(size_t id, ofstream& ofs) const
+{
+        uint32_t length = lengths[id];
+        ofs.write((char*)&length, sizeof(length));
+        ofs.write((char*)getBuffer(id), (length + 3) / 4);
+}
+
+void SequenceArena::read(size_t id, ifstream& ifs)
+{
+        uint32_t length;
+        ifs.read((char*)&length, sizeof(length));
+        if (!ifs.good()) {
+                clearSequence(id);
+                return;
+        }
+
+        size_t offset = allocate(length);
+        ifs.read((char*)(words.data() + offset), (length + 3) / 4);
+
+        // clear the bits past the end of the sequence
+        if (length % 32 != 0)
+                words[offset + getNumWords(length) - 1] &=
+                        (uint64_t(1) << (2 * (length % 32))) - 1;
+
+        assign(id, offset, length);
+}
@@ -0,0 +1,464 @@
+/***************************************************************************
+ *   Copyright (C) 2014, 2015 Jan Fostier (jan.fostier@intec.ugent.be)     *
+ *   Copyright (C) 2014, 2015 Mahdi Heydari (mahdi.heydari@intec.ugent.be) *
+ *   This file is part of Brownie                                          *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SEQUENCEARENA_H
+#define SEQUENCEARENA_H
+
+#include "global.h"
+#include "nucleotide.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+// ============================================================================
+// PACKED SEQUENCE CLASS
+// ============================================================================
+
+/**
+ * A (read) sequence packed in the 2-bit layout of the sequence arena, such
+ * that it can be compared to node sequences 32 nucleotides at a time.
+ * Characters other than 'A', 'C', 'G' and 'T' are flagged as invalid.
+ */
+class PackedSequence {
+
+private:
+        std::vector<uint64_t> words;    // 2-bit encoded nucleotides (+1 guard)
+        std::vector<uint64_t> invalid;  // 01 for non-ACGT characters (+1 guard)
+        std::vector<uint64_t> wildcard; // 01 for 'N' characters (+1 guard)
+        size_t length;                  // number of nucleotides
+
+        /**
+         * Get 32 2-bit fields starting at an arbitrary position
+         * @param v Vector with the 2-bit fields
+         * @param pos Position of the first field
+         * @return 32 2-bit fields
+         */
+        static uint64_t getWord(const std::vector<uint64_t>& v, size_t pos) {
+                const uint64_t *w = v.data() + pos / 32;
+                size_t shift = 2 * (pos % 32);
+                if (shift == 0)
+                        return w[0];
+                return (w[0] >> shift) | (w[1] << (64 - shift));
+        }
+
+public:
+        /**
+         * Default constructor
+         */
+        PackedSequence() : length(0) {}
+
+        /**
+         * Pack a string, the memory of a previous string is reused
+         * @param str String to pack
+         * @param revCompl Pack the reverse complement of the string
+         */
+        void pack(const std::string& str, bool revCompl = false);
+
+        /**
+         * Get the number of nucleotides
+         * @return The number of nucleotides
+         */
+        size_t getLength() const {
+                return length;
+        }
+
+        /**
+         * Get 32 nucleotides starting at an arbitrary position
+         * @param pos Position of the first nucleotide
+         * @return 32 nucleotides, 2-bit encoded
+         */
+        uint64_t getWord(size_t pos) const {
+                return getWord(words, pos);
+        }
+
+        /**
+         * Get the invalid flags of 32 nucleotides
+         * @param pos Position of the first nucleotide
+         * @return Bit pattern 01 for every invalid nucleotide
+         */
+        uint64_t getInvalidWord(size_t pos) const {
+                return getWord(invalid, pos);
+        }
+
+        /**
+         * Get the wildcard ('N') flags of 32 nucleotides
+         * @param pos Position of the first nucleotide
+         * @return Bit pattern 01 for every wildcard
+         */
+        uint64_t getWildcardWord(size_t pos) const {
+                return getWord(wildcard, pos);
+        }
+};
+
+// ============================================================================
+// SEQUENCE ARENA CLASS
+// ============================================================================
+
+/**
+ * Contiguous store for the 2-bit encoded sequences of all nodes. Every
+ * sequence starts at a 64-bit word boundary and uses the same bit layout as
+ * a TString (nucleotide i at bits 2*(i%32) of word i/32). Replaced sequences
+ * leave dead space behind, which is reclaimed by compacting the arena.
+ */
+class SequenceArena {
+
+private:
+        std::vector<uint64_t> words;    // 2-bit encoded sequences (+1 guard)
+        std::vector<uint64_t> offsets;  // word offset of each sequence
+        std::vector<uint32_t> lengths;  // length of each sequence
+        size_t numUsedWords;            // number of words in use (dead + live)
+        size_t numDeadWords;            // number of unreferenced words
+        bool lengthsOnly;               // only the lengths are maintained
+
+        /**
+         * Get the number of words required to store a sequence
+         * @param length Number of nucleotides
+         * @return The number of 64-bit words
+         */
+        static size_t getNumWords(size_t length) {
+                return (length + 31) / 32;
+        }
+
+        /**
+         * Get 32 nucleotides starting at an arbitrary position
+         * @param wordOffset Word offset of the sequence
+         * @param pos Nucleotide position relative to wordOffset
+         * @return 32 nucleotides, 2-bit encoded
+         */
+        uint64_t getWord(size_t wordOffset, size_t pos) const {
+                const uint64_t *w = words.data() + wordOffset + pos / 32;
+                size_t shift = 2 * (pos % 32);
+                if (shift == 0)
+                        return w[0];
+                return (w[0] >> shift) | (w[1] << (64 - shift));
+        }
+
+        /**
+         * Or at most 32 nucleotides into the arena at an arbitrary position
+         * @param wordOffset Word offset of the destination sequence
+         * @param pos Nucleotide position relative to wordOffset
+         * @param value Nucleotides to write (2-bit encoded)
+         * @param num Number of nucleotides to write [1..32]
+         */
+        void orWord(size_t wordOffset, size_t pos, uint64_t value, size_t num) {
+                if (num < 32)
+                        value &= (uint64_t(1) << (2 * num)) - 1;
+                uint64_t *w = words.data() + wordOffset + pos / 32;
+                size_t shift = 2 * (pos % 32);
+                w[0] |= value << shift;
+                if ((shift > 0) && (shift + 2 * num > 64))
+                        w[1] |= value >> (64 - shift);
+        }
+
+        /**
+         * Reverse complement 32 nucleotides
+         * @param w 32 nucleotides, 2-bit encoded
+         * @return The reverse complement
+         */
+        static uint64_t revComplWord(uint64_t w) {
+                w = (((w & 0xccccccccccccccccull) >> 2) |
+                     ((w & 0x3333333333333333ull) << 2));
+                w = (((w & 0xf0f0f0f0f0f0f0f0ull) >> 4) |
+                     ((w & 0x0f0f0f0f0f0f0f0full) << 4));
+                w = (((w & 0xff00ff00ff00ff00ull) >> 8) |
+                     ((w & 0x00ff00ff00ff00ffull) << 8));
+                w = (((w & 0xffff0000ffff0000ull) >> 16) |
+                     ((w & 0x0000ffff0000ffffull) << 16));
+                w = (((w & 0xffffffff00000000ull) >> 32) |
+                     ((w & 0x00000000ffffffffull) << 32));
+                return ~w;
+        }
+
+        /**
+         * Get 32 nucleotides of a sequence in a given orientation
+         * @param id Sequence identifier
+         * @param pos Position in the (reverse complemented) sequence
+         * @param num Number of valid nucleotides requested [1..32]
+         * @param revCompl Read the reverse complement of the sequence
+         * @return Nucleotides, 2-bit encoded (only num are valid)
+         */
+        uint64_t getOrientedWord(size_t id, size_t pos, size_t num,
+                                 bool revCompl) const {
+                if (!revCompl)
+                        return getWord(offsets[id], pos);
+                size_t fwdPos = lengths[id] - pos - num;
+                return revComplWord(getWord(offsets[id], fwdPos)) >> (2 * (32 - num));
+        }
+
+        /**
+         * Get a 01 bit pattern for every differing pair of nucleotides
+         * @param a 32 nucleotides, 2-bit encoded
+         * @param b 32 nucleotides, 2-bit encoded
+         * @return Bit pattern 01 at every differing position
+         */
+        static uint64_t getMismatchMask(uint64_t a, uint64_t b) {
+                uint64_t diff = a ^ b;
+                return (diff | (diff >> 1)) & 0x5555555555555555ull;
+        }
+
+        /**
+         * Make sure the word vector can hold numUsedWords + 1 guard word
+         */
+        void growWords() {
+                if (words.size() < numUsedWords + 1)
+                        words.resize(numUsedWords + 1, 0);
+        }
+
+        /**
+         * Release the words occupied by a sequence
+         * @param id Sequence identifier
+         */
+        void release(size_t id);
+
+public:
+        /**
+         * Default constructor
+         */
+        SequenceArena() : numUsedWords(0), numDeadWords(0),
+                lengthsOnly(false) {}
+
+        /**
+         * Clear the arena and copy only the sequence lengths of another
+         * arena. Sequences can not be accessed afterwards, but allocate,
+         * copy, assign and append keep the lengths up-to-date.
+         * @param source Arena to copy the lengths from
+         */
+        void cloneLengths(const SequenceArena& source);
+
+        /**
+         * Check whether the arena only maintains sequence lengths
+         * @return True if the sequences are not stored
+         */
+        bool isLengthsOnly() const {
+                return lengthsOnly;
+        }
+
+        /**
+         * Clear the arena and make room for a number of empty sequences
+         * @param numSequences Number of sequences
+         * @param expNumNucleotides Expected total number of nucleotides
+         */
+        void reset(size_t numSequences, size_t expNumNucleotides = 0);
+
+        /**
+         * Free all memory
+         */
+        void clear();
+
+        /**
+         * Get the number of sequences in the arena
+         * @return The number of sequences
+         */
+        size_t getNumSequences() const {
+                return lengths.size();
+        }
+
+        /**
+         * Get the length of a sequence
+         * @param id Sequence identifier
+         * @return The number of nucleotides
+         */
+        size_t getLength(size_t id) const {
+                return lengths[id];
+        }
+
+        /**
+         * Get the 2-bit encoded buffer of a sequence (TString layout)
+         * @param id Sequence identifier
+         * @return Pointer to the first byte of the sequence
+         */
+        const uint8_t* getBuffer(size_t id) const {
+                return (const uint8_t*)(words.data() + offsets[id]);
+        }
+
+        /**
+         * Get a nucleotide from a sequence
+         * @param id Sequence identifier
+         * @param pos Position in the sequence
+         * @return The nucleotide at that position
+         */
+        char getNucleotide(size_t id, size_t pos) const {
+                uint64_t w = words[offsets[id] + pos / 32];
+                return Nucleotide::nucleotideToChar(w >> (2 * (pos % 32)));
+        }
+
+        /**
+         * Get the length of the common prefix of a subsequence and a
+         * packed string. Invalid characters in the string never match.
+         * @param id Sequence identifier
+         * @param pos Start position in the (reverse complemented) sequence
+         * @param revCompl Use the reverse complement of the sequence
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param maxLen Maximum number of nucleotides to compare
+         * @return The number of matching nucleotides [0..maxLen]
+         */
+        size_t getMatchLength(size_t id, size_t pos, bool revCompl,
+                              const PackedSequence& str, size_t strPos,
+                              size_t maxLen) const;
+
+        /**
+         * Count the mismatches between a subsequence and an equally long
+         * part of a packed string. As in the aligner, an 'N' matches
+         * anything.
+         * @param id Sequence identifier
+         * @param pos Start position in the (reverse complemented) sequence
+         * @param revCompl Use the reverse complement of the sequence
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param len Number of nucleotides to compare
+         * @return The number of mismatches
+         */
+        size_t countMismatches(size_t id, size_t pos, bool revCompl,
+                               const PackedSequence& str, size_t strPos,
+                               size_t len) const;
+
+        /**
+         * Set a sequence from an stl string
+         * @param id Sequence identifier
+         * @param str String containing only 'A', 'C', 'G' and 'T'
+         */
+        void setSequence(size_t id, const std::string& str);
+
+        /**
+         * Get a sequence as an stl string
+         * @param id Sequence identifier
+         * @return Stl string containing the sequence
+         */
+        std::string getSequence(size_t id) const {
+                return substr(id, 0, lengths[id]);
+        }
+
+        /**
+         * Get a subsequence
+         * @param id Sequence identifier
+         * @param offset Start offset
+         * @param len Length of the subsequence
+         * @return Stl string containing the subsequence
+         */
+        std::string substr(size_t id, size_t offset, size_t len) const;
+
+        /**
+         * Remove a sequence (its space becomes dead space)
+         * @param id Sequence identifier
+         */
+        void clearSequence(size_t id) {
+                release(id);
+                lengths[id] = 0;
+        }
+
+        /**
+         * Allocate zero-initialized space for a new sequence. The space is
+         * filled with copy() and handed to a sequence with assign().
+         * @param length Number of nucleotides
+         * @return Word offset of the allocated space
+         */
+        size_t allocate(size_t length);
+
+        /**
+         * Copy (part of) a sequence into allocated space
+         * @param dstOffset Word offset of the destination space
+         * @param dstPos Nucleotide position in the destination space
+         * @param srcID Source sequence identifier
+         * @param srcPos First nucleotide of the source to copy
+         * @param len Number of nucleotides to copy
+         * @param revCompl Copy the reverse complement of the source range
+         */
+        void copy(size_t dstOffset, size_t dstPos, size_t srcID,
+                  size_t srcPos, size_t len, bool revCompl);
+
+        /**
+         * Let a sequence point to allocated space, the previous space of the
+         * sequence becomes dead space. The arena is not compacted, such that
+         * other allocated but unassigned space remains valid.
+         * @param id Sequence identifier
+         * @param offset Word offset of the allocated space
+         * @param length Number of nucleotides
+         */
+        void assign(size_t id, size_t offset, size_t length);
+
+        /**
+         * Append (part of) a sequence to the back of another sequence. When
+         * the destination sequence is stored at the end of the arena, it is
+         * extended in place.
+         * @param dstID Destination sequence identifier
+         * @param srcID Source sequence identifier
+         * @param srcPos First nucleotide of the source to append
+         * @param len Number of nucleotides to append
+         * @param revCompl Append the reverse complement of the source range
+         */
+        void append(size_t dstID, size_t srcID, size_t srcPos, size_t len,
+                    bool revCompl);
+
+        /**
+         * Move all live sequences to a new, dense buffer
+         */
+        void compact();
+
+        /**
+         * Keep only a subset of the sequences, renumber them and move them
+         * to a new, dense buffer
+         * @param order Old identifiers of the sequences to keep, sequence
+         * order[i] gets identifier i
+         */
+        void compact(const std::vector<size_t>& order);
+
+        /**
+         * Compact the arena when more than half of the used words are dead
+         */
+        void reclaim() {
+                if (numDeadWords > numUsedWords / 2)
+                        compact();
+        }
+
+        /**
+         * Get the number of unreferenced words
+         * @return The number of unreferenced words
+         */
+        size_t getNumDeadWords() const {
+                return numDeadWords;
+        }
+
+        /**
+         * Get the number of words in use (live and dead)
+         * @return The number of words in use
+         */
+        size_t getNumUsedWords() const {
+                return numUsedWords;
+        }
+
+        /**
+         * Write a sequence to file (same format as TString::write)
+         * @param id Sequence identifier
+         * @param ofs Open output file stream
+         */
+        void write(size_t id, std::ofstream& ofs) const;
+
+        /**
+         * Read a sequence from file (same format as TString::read)
+         * @param id Sequence identifier
+         * @param ifs Open input file stream
+         */
+        void read(size_t id, std::ifstream& ifs);
+};
+
+#endif
@@ -66,14 +66,19 @@ void Settings::printUsage() const
         cout << " [options]\n";
         cout << "  -h\t--help\t\t\tdisplay help page\n";
         cout << "  -i\t--info\t\t\tdisplay information page\n";
-        cout << "  -s\t--singlestranded\tenable single stranded DNA [default = false]\n\n";
+        cout << "  -s\t--singlestranded\tenable single stranded DNA [default = false]\n";
+        cout << "  -b\t--bestfirst\t\tuse best-first instead of depth-first search during read correction [default = false]\n\n";
 
         cout << " [options arg]\n";
         cout << "  -k\t--kmersize\t\tkmer size [default = 31]\n";
         cout << "  -t\t--threads\t\tnumber of threads [default = available cores]\n";
         cout << "  -v\t--visits\t\tmaximum number of visited nodes during bubble detection [default = 1000]\n";
-        cout << "  -d\t--depth\t\t\tmaximum number of visited nodes during read correction [default = 1000]\n";
+        cout << "  -d\t--depth\t\t\tmaximum number of visited (-b: expanded) nodes during read correction [default = 1000]\n";
+        cout << "  -w\t--workbudget\t\tmaximum number of visited (-b: expanded) nodes per read during read correction [default = 0 (no limit)]\n";
+        cout << "  -r\t--retrybudget\t\twork budget for reads that exceed -w, these are retried when no other reads are available [default = 0 (no retry)]\n";
+        cout << "  -x\t--cachesize\t\tmaximum number of reads in the duplicate read cache during read correction [default = 100000, 0 = no cache]\n";
         cout << "  -e\t--essa\t\t\tsparseness factor of the enhanced sparse suffix array [default = 1]\n";
+        cout << "  -m\t--minimizer\t\tuse a minimizer index with this window size instead of the suffix array [default = 0 (suffix array)]\n";
         cout << "  -c\t--cutoff\t\tvalue to separate true and false nodes based on their coverage [default = calculated based on poisson mixture model]\n";
 
         cout << "  -p\t--pathtotmp\t\tpath to directory to store temporary files [default = current directory]\n\n";
@@ -91,8 +96,9 @@ void Settings::printUsage() const
 // ============================================================================
 
 Settings::Settings() : kmerSize(31), numThreads(std::thread::hardware_concurrency()),
-        doubleStranded(true), essaMEMSparsenessFactor(1), bubbleDFSNodeLimit(1000),
-        readCorrDFSNodeLimit(1000), covCutoff(0), skipStage4(false), skipStage5(false) {}
+        doubleStranded(true), essaMEMSparsenessFactor(1), minimizerWindowSize(0), bubbleDFSNodeLimit(1000),
+        readCorrDFSNodeLimit(1000), bestFirstReadCorr(false),
+        readCorrWorkBudget(0), readCorrRetryBudget(0), readCacheSize(100000), covCutoff(0), skipStage4(false), skipStage5(false) {}
 
 void Settings::parseCommandLineArguments(int argc, char** args,
                                          LibraryContainer& libCont)
@@ -134,6 +140,10 @@ void Settings::parseCommandLineArguments(int argc, char** args,
                         i++;
                         if (i < argc)
                                 essaMEMSparsenessFactor = atoi(args[i]);
+                } else if ((arg == "-m") || (arg == "--minimizer")) {
+                        i++;
+                        if (i < argc)
+                                minimizerWindowSize = atoi(args[i]);
                 } else if ((arg == "-v") || (arg == "--visits")) {
                         i++;
                         if (i < argc)
@@ -142,12 +152,26 @@ void Settings::parseCommandLineArguments(int argc, char** args,
                         i++;
                         if (i < argc)
                                 readCorrDFSNodeLimit = atoi(args[i]);
+                } else if ((arg == "-w") || (arg == "--workbudget")) {
+                        i++;
+                        if (i < argc)
+                                readCorrWorkBudget = atoi(args[i]);
+                } else if ((arg == "-r") || (arg == "--retrybudget")) {
+                        i++;
+                        if (i < argc)
+                                readCorrRetryBudget = atoi(args[i]);
+                } else if ((arg == "-x") || (arg == "--cachesize")) {
+                        i++;
+                        if (i < argc)
+                                readCacheSize = atoi(args[i]);
                 } else if ((arg == "-c") || (arg == "--cutoff")) {
                         i++;
                         if (i < argc)
                                 covCutoff = atoi(args[i]);
                 } else if ((arg == "-s") || (arg == "--singlestranded")) {
                         doubleStranded = false;
+                } else if ((arg == "-b") || (arg == "--bestfirst")) {
+                        bestFirstReadCorr = true;
                 } else if ((arg == "-p") || (arg == "--pathtotmp")) {
                         i++;
                         if (i < argc)
@@ -53,8 +53,13 @@ private:
         std::string pathtotemp;         // directory specified by user
 
         int essaMEMSparsenessFactor;    // sparseness factor for essaMEM
+        int minimizerWindowSize;        // minimizer window size (0 = essaMEM)
         int bubbleDFSNodeLimit;         // maximum number of visited nodes during bubble detection
         int readCorrDFSNodeLimit;       // maximal number of visited nodes during read mapping
+        bool bestFirstReadCorr;         // best-first instead of depth-first search during read mapping
+        int readCorrWorkBudget;         // maximum number of visited nodes per read (0 = no limit)
+        int readCorrRetryBudget;        // work budget for reads that are retried (0 = no retry)
+        int readCacheSize;              // maximum number of reads in the duplicate read cache
         double covCutoff;               // coverage cutoff value to separate true and false nodes based on their node-kmer-coverage
         bool skipStage4;                // true if stage 4 should be skipped
         bool skipStage5;                // true if stage 5 should be skipped
@@ -130,6 +135,14 @@ public:
                 return essaMEMSparsenessFactor;
         }
 
+        /**
+         * Get the window size of the minimizer seed index
+         * @return The window size, 0 if essaMEM should be used instead
+         */
+        int getMinimizerWindowSize() const {
+                return minimizerWindowSize;
+        }
+
         /**
          * Get the maximum number of nodes visited during a DFS during bubble detection
          * @return The maximum number of nodes visited during bubble detection
@@ -146,6 +159,40 @@ public:
                 return readCorrDFSNodeLimit;
         }
 
+        /**
+         * True if read correction should use the best-first search engine
+         * @return True if read correction should use the best-first search
+         */
+        bool useBestFirstReadCorr() const {
+                return bestFirstReadCorr;
+        }
+
+        /**
+         * Get the maximum number of visited nodes per read during read
+         * correction, summed over all seeds
+         * @return The work budget per read (0 = no limit)
+         */
+        size_t getReadCorrWorkBudget() const {
+                return readCorrWorkBudget > 0 ? readCorrWorkBudget : 0;
+        }
+
+        /**
+         * Get the work budget for reads that exceeded the regular work
+         * budget and are retried once the other reads are corrected
+         * @return The retry budget per read (0 = no retry)
+         */
+        size_t getReadCorrRetryBudget() const {
+                return readCorrRetryBudget > 0 ? readCorrRetryBudget : 0;
+        }
+
+        /**
+         * Get the maximum number of reads in the duplicate read cache
+         * @return The cache size (0 = no cache)
+         */
+        size_t getReadCacheSize() const {
+                return readCacheSize > 0 ? readCacheSize : 0;
+        }
+
         /**
          * True if stage 4 should be skipped
          * @return True if stage 4 should be skipped
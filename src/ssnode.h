@@ -516,6 +516,34 @@ public:
                         return Nucleotide::getRevCompl(dsNode->substr(getLength() - len - offset, len));
         }
 
+        /**
+         * Get the length of the common prefix of a subsequence of this node
+         * and a packed string (compared 32 nucleotides at a time)
+         * @param pos Start position in the node
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param maxLen Maximum number of nucleotides to compare
+         * @return The number of matching nucleotides
+         */
+        size_t getMatchLength(size_t pos, const PackedSequence& str,
+                              size_t strPos, size_t maxLen) const {
+                return dsNode->getMatchLength(pos, nodeID < 0, str, strPos, maxLen);
+        }
+
+        /**
+         * Count the mismatches between a subsequence of this node and a
+         * packed string (compared 32 nucleotides at a time)
+         * @param pos Start position in the node
+         * @param str Packed string
+         * @param strPos Start position in the packed string
+         * @param len Number of nucleotides to compare
+         * @return The number of mismatches
+         */
+        size_t countMismatches(size_t pos, const PackedSequence& str,
+                               size_t strPos, size_t len) const {
+                return dsNode->countMismatches(pos, nodeID < 0, str, strPos, len);
+        }
+
         /**
          * Get a nucleotide at a specified position ('-' for out-of bounds)
          * @param pos Position in the sequence
@@ -88,6 +88,13 @@ public:
          */
         TKmer(const TString &tString, size_t offset = 0);
 
+        /**
+         * Create a kmer from a 2-bit encoded buffer (tight string layout)
+         * @param packed Buffer holding at least offset + k nucleotides
+         * @param offset Offset marking the starting position
+         */
+        TKmer(const uint8_t *packed, size_t offset);
+
         /**
          * Create a kmer from an input file stream
          * @param ifs Opened input file stream
@@ -391,6 +398,34 @@ TKmer<numBytes>::TKmer(const char* str)
         memcpy(buf, work, numBytes);
 }
 
+template<size_t numBytes>
+TKmer<numBytes>::TKmer(const uint8_t *packed, size_t offset)
+{
+        // clear bytes
+        const size_t llSize = numBytes / 8 + 1;
+        uint64_t work[llSize];
+
+        memcpy(work, packed + offset / 4, (k + (offset % 4) + 3) / 4);
+
+        // shift the words to the right
+        uint64_t leftBits = 0, rightBits = 0;
+        int numRightBits = 2*(offset % 4);
+        int numLeftBits = 64 - numRightBits;
+        uint64_t rightMask = (uint64_t(1) << numRightBits) - 1;
+        for (ssize_t i = llSize - 1; i >= 0; i--) {
+                rightBits = work[i] & rightMask;
+                work[i] = (work[i] >> numRightBits) | leftBits;
+                leftBits = rightBits << numLeftBits;
+        }
+
+        work[kMSLL] &= (uint64_t(1) << 2*(k % 32)) - 1;
+
+        for (size_t i = kMSLL + 1; i < llSize; i++)
+                work[i] = 0;
+
+        memcpy(buf, work, numBytes);
+}
+
 template<size_t numBytes>
 TKmer<numBytes>::TKmer(const std::string& str, size_t offset)
 {
@@ -418,33 +418,10 @@ inline RevTStringIt& RevTStringIt::operator++()
 // ============================================================================
 
 template<size_t numBytes>
-TKmer<numBytes>::TKmer(const TString& tString, size_t offset)
+TKmer<numBytes>::TKmer(const TString& tString, size_t offset) :
+        TKmer(tString.buf, offset)
 {
         assert(tString.getLength() >= (k + offset));
-
-        // clear bytes
-        const size_t llSize = numBytes / 8 + 1;
-        uint64_t work[llSize];
-
-        memcpy(work, tString.buf + offset / 4, (k + (offset % 4) + 3) / 4);
-
-        // shift the words to the right
-        uint64_t leftBits = 0, rightBits = 0;
-        int numRightBits = 2*(offset % 4);
-        int numLeftBits = 64 - numRightBits;
-        uint64_t rightMask = (uint64_t(1) << numRightBits) - 1;
-        for (ssize_t i = llSize - 1; i >= 0; i--) {
-                rightBits = work[i] & rightMask;
-                work[i] = (work[i] >> numRightBits) | leftBits;
-                leftBits = rightBits << numLeftBits;
-        }
-
-        work[kMSLL] &= (uint64_t(1) << 2*(k % 32)) - 1;
-
-        for (size_t i = kMSLL + 1; i < llSize; i++)
-                work[i] = 0;
-
-        memcpy(buf, work, numBytes);
 }
 
 #endif
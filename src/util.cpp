@@ -23,6 +23,7 @@
 #include "global.h"
 #include <ctime>
 #include <sstream>
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -88,3 +89,62 @@ double Util::poissonPDF(unsigned int k, double mu)
 {
         return exp(k*log(mu)-mu-lgamma(k+1));
 }
+
+int Util::estimateMultiplicity(unsigned int readStartCov, double mu1,
+                               double& confidenceRatio,
+                               double& inCorrctnessRatio)
+{
+        if (!(mu1 > 0) || std::isinf(mu1)) {
+                confidenceRatio=0;
+                inCorrctnessRatio=1;
+                return 0;
+        }
+
+        // log(k!) does not depend on the multiplicity
+        const double logFactK=lgamma(readStartCov+1.0);
+        auto logProb = [&](double mult) {
+                return logPoissonPDF(readStartCov, mult*mu1, logFactK);
+        };
+
+        // the log-likelihood is concave in the multiplicity: its maximum
+        // is found next to readStartCov/mu1
+        double mult=max(1.0, floor(min(readStartCov/mu1, 1e9)));
+        if (logProb(mult+1)>logProb(mult))
+                mult++;
+        int nodeMultiplicity=mult;
+
+        // sum the probabilities of the alternatives, relative to the maximum,
+        // alternating between lower and higher multiplicities
+        const double logMax=logProb(nodeMultiplicity);
+        const double maxProb=exp(logMax);
+        double newProbability=exp(logProb(nodeMultiplicity+1)-logMax);
+        double currentProb=0;
+        double denominator=0;
+        int i = 1;
+        bool minus=true;
+        do{
+                currentProb=newProbability;
+                int newMult=0;
+                if (minus&& nodeMultiplicity>i){
+                        newMult=nodeMultiplicity-i;
+                        minus=false;
+                }
+                else{
+                        newMult=nodeMultiplicity+i;
+                        minus=true;
+                        i++;
+                }
+                newProbability=exp(logProb(newMult)-logMax);
+                denominator=denominator+newProbability;
+        }while(abs(newProbability-currentProb)*maxProb> .000001|| i<5);
+        confidenceRatio=1/denominator;
+
+        double expectToSee=mu1*nodeMultiplicity;
+        unsigned int expectedCov=expectToSee;
+        double logExpected=logPoissonPDF(expectedCov, expectToSee);
+        double logObserved=logExpected;
+        if(readStartCov<expectToSee)
+                logObserved=logProb(nodeMultiplicity);
+        inCorrctnessRatio=exp(logExpected-logObserved);
+        return nodeMultiplicity;
+}
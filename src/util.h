@@ -26,6 +26,7 @@
 #include <chrono>
 #include <ctime>
 #include <fstream>
+#include <cmath>
 #define MAX_TIMERS 16
 
 /**
@@ -105,6 +106,49 @@ public:
          */
         static double poissonPDF(unsigned int k, double mu);
 
+        /**
+         * Compute the log-probability log(p(k)) from a Poisson distribution
+         * with mean mu, this does not underflow for large k or mu
+         * @param k Number of observations
+         * @param mu Expected number of observation (mean of distribution)
+         * @param logFactK Precomputed value of log(k!) = lgamma(k+1)
+         * @return The log-probability log(p(k))
+         */
+        static double logPoissonPDF(unsigned int k, double mu, double logFactK) {
+                if (mu <= 0)
+                        return (k == 0) ? 0 : -INFINITY;
+                return k*log(mu)-mu-logFactK;
+        }
+
+        /**
+         * Compute the log-probability log(p(k)) from a Poisson distribution
+         * with mean mu, this does not underflow for large k or mu
+         * @param k Number of observations
+         * @param mu Expected number of observation (mean of distribution)
+         * @return The log-probability log(p(k))
+         */
+        static double logPoissonPDF(unsigned int k, double mu) {
+                return logPoissonPDF(k, mu, lgamma(k+1.0));
+        }
+
+        /**
+         * Estimate the multiplicity of a node from its read start coverage,
+         * which follows a Poisson distribution with mean multiplicity*mu1.
+         * All probabilities are evaluated in log-space, so there is no
+         * underflow for nodes with a very high coverage.
+         * @param readStartCov Read start coverage of the node
+         * @param mu1 Expected read start coverage for multiplicity one
+         * @param confidenceRatio Probability of the guess divided by the sum
+         * of the probabilities of the other multiplicities (output)
+         * @param inCorrctnessRatio Probability of the expected read start
+         * coverage divided by that of the observed one (output)
+         * @return The most likely multiplicity (at least one), zero if mu1
+         * is not a positive number
+         */
+        static int estimateMultiplicity(unsigned int readStartCov, double mu1,
+                                        double& confidenceRatio,
+                                        double& inCorrctnessRatio);
+
         /**
          * Compute the percentage of two size_t numbers
          * @param nom Nominator
@@ -53,3 +53,49 @@ TEST(Alignment, AlignmentTest)
 
         ASSERT_EQ(score, 6);
 }
+
+TEST(Alignment, SIMDTest)
+{
+        // the vectorized aligner must return the scalar scores
+        srand(1);
+        const char nucl[] = "ACGTN";
+        for (int maxIndel = 1; maxIndel <= 3; maxIndel++) {
+                AlignmentJan align(100, maxIndel, 1, -1, -3);
+                for (int t = 0; t < 500; t++) {
+                        string s1;
+                        int length = 10 + rand() % 90;
+                        for (int i = 0; i < length; i++)
+                                s1.push_back(nucl[rand() % ((t % 2) ? 5 : 4)]);
+
+                        // introduce random substitutions and indels
+                        string s2 = s1;
+                        for (int e = 0; e < 4; e++) {
+                                size_t pos = rand() % s2.size();
+                                switch (rand() % 3) {
+                                        case 0: s2[pos] = nucl[rand() % 4]; break;
+                                        case 1: s2.insert(pos, 1, nucl[rand() % 4]); break;
+                                        case 2: s2.erase(pos, 1); break;
+                                }
+                        }
+
+                        int len1 = s1.size(), len2 = s2.size();
+                        if (abs(len1 - len2) > maxIndel)
+                                continue;
+
+                        int score = align.align(s1, s2);
+                        ASSERT_EQ(score, align.alignScalar(s1, s2));
+
+                        // bounded alignment: exact score or below the bound
+                        int minScore = score - 5 + rand() % 11;
+                        int bounded = align.alignBounded(s1, s2, minScore);
+                        int boundedScalar = align.alignScalar(s1, s2, minScore);
+                        if (score >= minScore) {
+                                ASSERT_EQ(bounded, score);
+                                ASSERT_EQ(boundedScalar, score);
+                        } else {
+                                ASSERT_LT(bounded, minScore);
+                                ASSERT_LT(boundedScalar, minScore);
+                        }
+                }
+        }
+}
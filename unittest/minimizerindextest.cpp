@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "minimizerindex.h"
+
+#include <cstdlib>
+#include <set>
+
+using namespace std;
+
+TEST(MinimizerIndex, minimizerTest)
+{
+        srand(5);
+        string seq;
+        for (int i = 0; i < 500; i++)
+                seq.push_back("ACGT"[rand() % 4]);
+        seq[250] = 'N';
+
+        const size_t k = 11, w = 8;
+        MinimizerIndex index(k, w);
+        vector<Minimizer> minimizers;
+        index.getMinimizers(seq, minimizers);
+
+        // every window of w valid k-mers contains a minimizer
+        ASSERT_FALSE(minimizers.empty());
+        for (size_t i = 1; i < minimizers.size(); i++) {
+                EXPECT_LT(minimizers[i-1].pos, minimizers[i].pos);
+                if (minimizers[i].pos < 250 || minimizers[i-1].pos > 250) {
+                        EXPECT_LE(minimizers[i].pos - minimizers[i-1].pos, w);
+                }
+        }
+
+        // k-mers that overlap the 'N' are never selected
+        for (auto& it : minimizers)
+                EXPECT_TRUE(it.pos + k <= 250 || it.pos > 250);
+
+        // a sequence shorter than k has no minimizers
+        index.getMinimizers(seq.substr(0, k - 1), minimizers);
+        EXPECT_TRUE(minimizers.empty());
+}
+
+TEST(MinimizerIndex, findHitsTest)
+{
+        srand(7);
+        vector<string> nodes(20);
+        for (auto& it : nodes)
+                for (int i = 0, len = 50 + rand() % 300; i < len; i++)
+                        it.push_back("ACGT"[rand() % 4]);
+
+        MinimizerIndex index(13, 6);
+        for (size_t i = 0; i < nodes.size(); i++)
+                index.addSequence(i + 1, nodes[i]);
+        index.finalize();
+        EXPECT_GT(index.getNumEntries(), 0u);
+
+        // a substring of node 5 with a substitution
+        string query = nodes[4].substr(10, 40);
+        query[20] = (query[20] == 'A') ? 'C' : 'A';
+
+        vector<MinimizerHit> hits;
+        index.findHits(query, hits);
+        ASSERT_FALSE(hits.empty());
+
+        set<pair<NodeID, int64_t> > diagonals;
+        for (auto& it : hits) {
+                diagonals.insert(make_pair(it.nodeID, it.getDiagonal()));
+                EXPECT_EQ(nodes[it.nodeID - 1].substr(it.nodePos, 13),
+                          query.substr(it.seqPos, 13));
+        }
+        EXPECT_TRUE(diagonals.count(make_pair(NodeID(5), int64_t(10))) == 1);
+
+        // repetitive minimizers are ignored
+        MinimizerIndex repIndex(13, 6, 3);
+        for (int i = 1; i <= 4; i++)
+                repIndex.addSequence(i, nodes[0]);
+        repIndex.finalize();
+        repIndex.findHits(nodes[0], hits);
+        EXPECT_TRUE(hits.empty());
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "readcache.h"
+
+#include <set>
+
+using namespace std;
+
+TEST(ReadCache, keyTest)
+{
+        // all prefixes of a read (every tail length) have different keys
+        string read = "ACGTTGCAACGGTACCATGACGTAGCTAGCTAGGATCCAGT";
+        set<pair<uint64_t, uint64_t> > keys;
+        for (size_t len = 0; len <= read.size(); len++) {
+                ReadKey key(read.substr(0, len));
+                keys.insert(make_pair(key.h1, key.h2));
+                EXPECT_TRUE(key == ReadKey(read.substr(0, len)));
+        }
+        EXPECT_EQ(keys.size(), read.size() + 1);
+
+        // a single substitution changes the key
+        string mutated = read;
+        mutated[20] = 'N';
+        EXPECT_FALSE(ReadKey(read) == ReadKey(mutated));
+}
+
+TEST(ReadCache, clockTest)
+{
+        ReadCache cache(3, 1);
+        CorrectedRead value;
+
+        for (int i = 0; i < 3; i++) {
+                value.read = string(10 + i, 'A');
+                value.corrected = true;
+                value.numSubstitutions = i;
+                cache.insert(ReadKey(string(10 + i, 'C')), value);
+        }
+
+        // only the first read is referenced when the cache is full: it gets
+        // a second chance, the other two are evicted instead
+        ASSERT_TRUE(cache.find(ReadKey(string(10, 'C')), value));
+        EXPECT_EQ(value.read, string(10, 'A'));
+        EXPECT_EQ(value.numSubstitutions, 0u);
+        EXPECT_FALSE(cache.find(ReadKey("CCC"), value));
+
+        cache.insert(ReadKey("G"), value);
+        cache.insert(ReadKey("T"), value);
+
+        EXPECT_TRUE(cache.find(ReadKey(string(10, 'C')), value));
+        EXPECT_TRUE(cache.find(ReadKey("G"), value));
+        EXPECT_TRUE(cache.find(ReadKey("T"), value));
+        EXPECT_FALSE(cache.find(ReadKey(string(11, 'C')), value));
+        EXPECT_FALSE(cache.find(ReadKey(string(12, 'C')), value));
+}
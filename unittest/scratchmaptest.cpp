@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "scratchmap.h"
+
+using namespace std;
+
+TEST(ScratchMap, insertGetTest)
+{
+        ScratchMap<int, int> map(4);
+        EXPECT_TRUE(map.empty());
+        EXPECT_EQ(map.get(5), 0);
+
+        // negative keys and enough elements to force a few rehashes
+        for (int i = -100; i <= 100; i++)
+                map[i] = 2 * i + 1;
+        EXPECT_EQ(map.size(), 201u);
+
+        for (int i = -100; i <= 100; i++) {
+                EXPECT_TRUE(map.contains(i));
+                EXPECT_EQ(map.get(i), 2 * i + 1);
+        }
+        EXPECT_FALSE(map.contains(101));
+        EXPECT_EQ(map.get(-101), 0);
+
+        map[7] += 3;
+        EXPECT_EQ(map.get(7), 18);
+        EXPECT_EQ(map.size(), 201u);
+}
+
+TEST(ScratchMap, clearTest)
+{
+        ScratchMap<int, int> map;
+        for (int i = 0; i < 50; i++)
+                map[i * 1000] = i + 1;
+
+        map.clear();
+        EXPECT_TRUE(map.empty());
+        for (int i = 0; i < 50; i++)
+                EXPECT_FALSE(map.contains(i * 1000));
+
+        // the map is reusable after a clear
+        map[3] = 4;
+        EXPECT_EQ(map.size(), 1u);
+        EXPECT_EQ(map.get(3), 4);
+        EXPECT_EQ(map.get(0), 0);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "sequencearena.h"
+
+using namespace std;
+
+TEST(SequenceArena, setGetTest)
+{
+        string source1("ACGTACGTACGTGGATTCCCGAACGTACGTACGTGGATTCCCGA");
+        string source2("CGGTAGGCTTAAAATTGCC");
+
+        SequenceArena arena;
+        arena.reset(3);
+        arena.setSequence(1, source1);
+        arena.setSequence(2, source2);
+
+        EXPECT_EQ(arena.getSequence(1), source1);
+        EXPECT_EQ(arena.getSequence(2), source2);
+        EXPECT_EQ(arena.getLength(0), 0u);
+        EXPECT_EQ(arena.getNucleotide(1, 33), source1[33]);
+        EXPECT_EQ(arena.substr(1, 30, 10), source1.substr(30, 10));
+
+        // replacing a sequence leaves dead space behind
+        arena.setSequence(1, source2);
+        EXPECT_EQ(arena.getSequence(1), source2);
+        EXPECT_EQ(arena.getNumDeadWords(), 2u);
+
+        arena.compact();
+        EXPECT_EQ(arena.getNumDeadWords(), 0u);
+        EXPECT_EQ(arena.getSequence(1), source2);
+        EXPECT_EQ(arena.getSequence(2), source2);
+
+        // keep and renumber a subset of the sequences
+        arena.setSequence(2, source1);
+        arena.compact(vector<size_t>{0, 2});
+        EXPECT_EQ(arena.getNumSequences(), 2u);
+        EXPECT_EQ(arena.getNumDeadWords(), 0u);
+        EXPECT_EQ(arena.getSequence(1), source1);
+}
+
+TEST(SequenceArena, appendTest)
+{
+        string source1("ACGTACGTACGTGGATTCCCGAACGTACGTACGTGGATTCCCGATTGA");
+        string source2("CGGTAGGCTTAAAATTGCCGGATCCATGACCAGTTACAGGATTTACCCAGG");
+        string source2RC = Nucleotide::getRevCompl(source2);
+
+        SequenceArena arena;
+        arena.reset(3);
+        arena.setSequence(1, source1);
+        arena.setSequence(2, source2);
+
+        // append to a sequence that is not at the end of the arena
+        arena.append(1, 2, 5, 40, false);
+        EXPECT_EQ(arena.getSequence(1), source1 + source2.substr(5, 40));
+
+        // append in place
+        arena.append(1, 2, 3, 37, true);
+        EXPECT_EQ(arena.getSequence(1), source1 + source2.substr(5, 40) +
+                  source2RC.substr(source2.size() - 40, 37));
+        EXPECT_EQ(arena.getSequence(2), source2);
+
+        // compose a new sequence
+        size_t offset = arena.allocate(70);
+        arena.copy(offset, 0, 2, 0, source2.size(), true);
+        arena.copy(offset, source2.size(), 2, 0, 70 - source2.size(), false);
+        arena.assign(0, offset, 70);
+        EXPECT_EQ(arena.getSequence(0), source2RC +
+                  source2.substr(0, 70 - source2.size()));
+
+        // a lengths-only clone follows the lengths
+        SequenceArena clone;
+        clone.cloneLengths(arena);
+        EXPECT_TRUE(clone.isLengthsOnly());
+        clone.append(1, 2, 0, 10, false);
+        EXPECT_EQ(clone.getLength(1), arena.getLength(1) + 10);
+        EXPECT_EQ(clone.getLength(2), source2.size());
+}
+
+TEST(SequenceArena, compareTest)
+{
+        string source("ACGTACGTACGTGGATTCCCGAACGTACGTACGTGGATTCCCGATTGACGGTAGGCTTAAAATTGCC");
+        string sourceRC = Nucleotide::getRevCompl(source);
+
+        SequenceArena arena;
+        arena.reset(1);
+        arena.setSequence(0, source);
+
+        // a read with substitutions, a wildcard and an invalid character
+        string read = sourceRC.substr(3, 60);
+        read[5] = 'A'; read[40] = 'N'; read[47] = 'R'; read[50] = 'C';
+
+        // reverse complement that leaves the other characters intact
+        string readRC(read.rbegin(), read.rend());
+        for (auto& c : readRC)
+                if (c == 'A' || c == 'C' || c == 'G' || c == 'T')
+                        c = Nucleotide::getComplement(c);
+
+        for (int rc = 0; rc < 2; rc++) {
+                PackedSequence packed;
+                packed.pack(rc ? readRC : read, rc == 1);
+                EXPECT_EQ(packed.getLength(), read.size());
+
+                const string& seq = rc ? sourceRC : source;
+                for (size_t pos = 0; pos < 10; pos++) {
+                        for (size_t strPos = 0; strPos < 10; strPos++) {
+                                size_t len = min(read.size() - strPos, seq.size() - pos);
+                                size_t match = 0, mism = 0;
+                                while (match < len && seq[pos + match] == read[strPos + match])
+                                        match++;
+                                for (size_t i = 0; i < len; i++)
+                                        if (read[strPos + i] != 'N' && seq[pos + i] != read[strPos + i])
+                                                mism++;
+
+                                EXPECT_EQ(arena.getMatchLength(0, pos, rc == 1, packed, strPos, len), match);
+                                EXPECT_EQ(arena.countMismatches(0, pos, rc == 1, packed, strPos, len), mism);
+                        }
+                }
+        }
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "essaMEM-master/sparseSA.hpp"
+
+#include <cstdlib>
+
+using namespace std;
+
+TEST(SparseSA, parallelConstructTest)
+{
+        // random sequences separated by '>', with a long repeat
+        srand(11);
+        string text, repeat;
+        for (int i = 0; i < 600; i++)
+                repeat.push_back("ACGT"[rand() % 4]);
+
+        vector<long> startpos;
+        for (int i = 0; i < 40; i++) {
+                startpos.push_back(text.size());
+                size_t len = 31 + rand() % 400;
+                for (size_t j = 0; j < len; j++)
+                        text.push_back("ACGT"[rand() % 4]);
+                if (i % 10 == 0)
+                        text.append(repeat);
+                text.push_back('>');
+        }
+
+        vector<string> descr(1, "");
+        for (long K = 1; K <= 3; K++) {
+                string S1 = text, S2 = text;
+                sparseSA serial(S1, descr, startpos, false, K, true, true, true, 1, 4, false, false, false);
+                sparseSA parallel(S2, descr, startpos, false, K, true, true, true, 1, 4, false, false, false);
+                serial.construct();
+                parallel.construct(3);
+
+                ASSERT_EQ(serial.SA.size(), parallel.SA.size());
+                for (size_t i = 0; i < serial.SA.size(); i++) {
+                        EXPECT_EQ(serial.SA[i], parallel.SA[i]);
+                        EXPECT_EQ(serial.ISA[i], parallel.ISA[i]);
+                        EXPECT_EQ(serial.LCP[i], parallel.LCP[i]);
+                        EXPECT_EQ(serial.CHILD[i], parallel.CHILD[i]);
+                }
+
+                ASSERT_EQ(serial.KMR.size(), parallel.KMR.size());
+                for (size_t i = 0; i < serial.KMR.size(); i++) {
+                        EXPECT_EQ(serial.KMR[i].left, parallel.KMR[i].left);
+                        EXPECT_EQ(serial.KMR[i].right, parallel.KMR[i].right);
+                }
+                EXPECT_EQ(serial.NKm1, parallel.NKm1);
+        }
+}
@@ -8,3 +8,102 @@ TEST(poissonPDF, poissonPDFTest)
         EXPECT_DOUBLE_EQ(0, Util::poissonPDF(1000, 10));
         EXPECT_DOUBLE_EQ(0, Util::poissonPDF(10000, 10));
 }
+
+TEST(logPoissonPDF, logPoissonPDFTest)
+{
+        EXPECT_NEAR(log(0.12511003572113349), Util::logPoissonPDF(10, 10), 1e-12);
+        EXPECT_NEAR(log(4.8646491820674864E-63), Util::logPoissonPDF(100, 10), 1e-9);
+        // no underflow where poissonPDF returns zero
+        EXPECT_NEAR(-3619.5430855, Util::logPoissonPDF(1000, 10), 1e-6);
+        EXPECT_LT(Util::logPoissonPDF(100000, 99000), Util::logPoissonPDF(100000, 100000));
+        EXPECT_DOUBLE_EQ(0, Util::logPoissonPDF(0, 0));
+}
+
+// the linear-space multiplicity estimate of the original extractStatistic()
+static int linearEstimateMultiplicity(unsigned int readStartCov, double mu1,
+                                      double& confidenceRatio,
+                                      double& inCorrctnessRatio)
+{
+        int nodeMultiplicity=1;
+        double maxProb=0;
+        double newValue=mu1*nodeMultiplicity;
+        double newProbability=Util::poissonPDF(readStartCov,newValue);
+        while(newProbability>maxProb) {
+                nodeMultiplicity++;
+                maxProb=newProbability;
+                newValue=mu1*nodeMultiplicity;
+                newProbability=Util::poissonPDF(readStartCov,newValue);
+        }
+
+        nodeMultiplicity--;
+
+        double denominator=0;
+        double currentProb=maxProb;
+
+        int i = 1;
+        bool minus=true;
+        do{
+                currentProb=newProbability;
+                double newValue=0;
+                if (minus&& nodeMultiplicity>i){
+                        newValue=mu1*(nodeMultiplicity-i);
+                        minus=false;
+                }
+                else{
+                        newValue=mu1*(nodeMultiplicity+i);
+                        minus=true;
+                        i++;
+                }
+                newProbability=Util::poissonPDF(readStartCov,newValue);
+                denominator=denominator+newProbability;
+        }while(abs(newProbability-currentProb)> .000001|| i<5);
+        confidenceRatio=maxProb/denominator;
+
+        double expectToSee=mu1*nodeMultiplicity;
+        double observedprob=0;
+        if(readStartCov<expectToSee)
+                observedprob=Util::poissonPDF(readStartCov,expectToSee);
+        else
+                observedprob=Util::poissonPDF(expectToSee,expectToSee);
+        inCorrctnessRatio=Util::poissonPDF(expectToSee,expectToSee)/observedprob;
+        return nodeMultiplicity;
+}
+
+TEST(estimateMultiplicity, linearSpaceTest)
+{
+        const unsigned int covs[] = {0, 1, 3, 7, 10, 24, 25, 26, 60, 99, 150};
+        const double mus[] = {0.5, 1.0, 2.5, 8.0, 12.5, 25.0, 40.0};
+
+        for (unsigned int cov : covs) {
+                for (double mu1 : mus) {
+                        double conf, inCorr, expConf, expInCorr;
+                        int mult = Util::estimateMultiplicity(cov, mu1, conf, inCorr);
+                        int expMult = linearEstimateMultiplicity(cov, mu1, expConf, expInCorr);
+
+                        EXPECT_EQ(expMult, mult) << cov << " " << mu1;
+                        EXPECT_NEAR(expConf, conf, 1e-9 * expConf) << cov << " " << mu1;
+                        EXPECT_NEAR(expInCorr, inCorr, 1e-9 * expInCorr) << cov << " " << mu1;
+                }
+        }
+
+        // mu1 == 0: the same multiplicity, but the linear-space ratios are
+        // 0/0, while the log-space ratios mark the guess as unreliable
+        for (unsigned int cov : covs) {
+                double conf, inCorr, expConf, expInCorr;
+                int mult = Util::estimateMultiplicity(cov, 0.0, conf, inCorr);
+                int expMult = linearEstimateMultiplicity(cov, 0.0, expConf, expInCorr);
+
+                EXPECT_EQ(expMult, mult) << cov;
+                EXPECT_EQ(0, mult) << cov;
+                EXPECT_TRUE(std::isnan(expConf) && std::isnan(expInCorr)) << cov;
+                EXPECT_EQ(0, conf) << cov;
+                EXPECT_EQ(1, inCorr) << cov;
+        }
+
+        // the linear-space estimate underflows for a high coverage
+        double conf, inCorr, expConf, expInCorr;
+        EXPECT_EQ(0, linearEstimateMultiplicity(150, 0.3, expConf, expInCorr));
+        EXPECT_EQ(500, Util::estimateMultiplicity(150, 0.3, conf, inCorr));
+        EXPECT_EQ(3, Util::estimateMultiplicity(30000, 10000.0, conf, inCorr));
+        EXPECT_GT(conf, 0);
+}